@@ -0,0 +1,438 @@
+// Microbenchmarks for the entry points of random.h and random_float.h, with
+// the single value, fill, multi-lane and _dispatch versions of each group next
+// to each other, so that e.g. the claim that xoshiro256+ is faster than
+// xoshiro256++ can be checked on the machine at hand.
+//
+// Usage: bench [--json] [--cpu N] [--time SECONDS] [FILTER...]
+//
+// Every benchmark writes BATCH values to a buffer that stays in L1 cache, so
+// the numbers are the cost of generating the values and not of the memory
+// they go to. A run repeats the batch for at least --time seconds (0.05 by
+// default), and the best and median of REPEATS runs are reported in ns per
+// value and GB/s of output. The thread is pinned to one CPU (--cpu, the current
+// one by default) so the runs don't migrate between cores. FILTER arguments
+// only run the benchmarks whose name contains one of them. --json prints the
+// results as a JSON object instead of a table.
+
+#define _GNU_SOURCE
+#define RANDOM_IMPLEMENTATION
+#include "random.h"
+#include "random_float.h"
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#define BATCH 4096
+#define REPEATS 7
+
+typedef struct {
+    RandomState state;
+    RandomStateX4 x4;
+    RandomStateX8 x8;
+    RandomBuffer buffer;
+    RandomBits bits;
+    RandomGaussianCache cache;
+    RandomAliasTable alias;
+    uint64_t threshold;
+    uint64_t counter;
+    RANDOM__ALIGN(64) unsigned char out[BATCH * 8];
+    uint32_t shuffle[BATCH];
+} Context;
+
+typedef void (*BenchFunction)(Context *c);
+
+// A single value function called BATCH times, with each value stored so the
+// calls can't be dropped
+#define SINGLE(name, type, expr) \
+    static void name(Context *c) { \
+        type *out = (type *)(void *)c->out; \
+        for (size_t i = 0; i < BATCH; i++) { \
+            out[i] = expr; \
+        } \
+    }
+
+// A function that produces step values per call
+#define STEPS(name, type, step, call) \
+    static void name(Context *c) { \
+        type *out = (type *)(void *)c->out; \
+        for (size_t i = 0; i < BATCH; i += step) { \
+            call; \
+        } \
+    }
+
+// A fill function called once for the whole batch
+#define FILL(name, type, call) \
+    static void name(Context *c) { \
+        type *out = (type *)(void *)c->out; \
+        const size_t n = BATCH; \
+        call; \
+    }
+
+// Generators
+SINGLE(b_random_u64, uint64_t, random_u64(&c->state))
+FILL(b_random_fill_u64, uint64_t, random_fill_u64(&c->state, out, n))
+FILL(b_random_fill_bytes, uint64_t, random_fill_bytes(&c->state, out, 8 * n))
+SINGLE(b_random_buffer_u64, uint64_t, random_buffer_u64(&c->buffer))
+STEPS(b_random_u64_x4, uint64_t, 4, random_u64_x4(&c->x4, out + i))
+STEPS(b_random_u64_x8, uint64_t, 8, random_u64_x8(&c->x8, out + i))
+FILL(b_random_fill_u64_x4, uint64_t, random_fill_u64_x4(&c->x4, out, n))
+FILL(b_random_fill_u64_x8, uint64_t, random_fill_u64_x8(&c->x8, out, n))
+FILL(b_random_fill_u64_x4_dispatch, uint64_t, random_fill_u64_x4_dispatch(&c->x4, out, n))
+FILL(b_random_fill_u64_x8_dispatch, uint64_t, random_fill_u64_x8_dispatch(&c->x8, out, n))
+FILL(b_random_fill_bytes_x8, uint64_t, random_fill_bytes_x8(&c->x8, out, 8 * n))
+FILL(b_random_fill_bytes_x8_dispatch, uint64_t, random_fill_bytes_x8_dispatch(&c->x8, out, 8 * n))
+SINGLE(b_rf__next, uint64_t, rf__next(&c->state))
+STEPS(b_rf__next_x4, uint64_t, 4, rf__next_x4(&c->x4, out + i))
+STEPS(b_rf__next_x8, uint64_t, 8, rf__next_x8(&c->x8, out + i))
+SINGLE(b_random_at, uint64_t, random_at(0x243f6a8885a308d3, c->counter++))
+FILL(b_random_fill_at, uint64_t, (random_fill_at(0x243f6a8885a308d3, c->counter, out, n), c->counter += n))
+SINGLE(b_random_bits_1, uint32_t, random_bits(&c->state, &c->bits, 1))
+SINGLE(b_random_bits_8, uint32_t, random_bits(&c->state, &c->bits, 8))
+SINGLE(b_random_bernoulli_mask, uint64_t, random_bernoulli_mask(&c->state, c->threshold))
+
+// Integer ranges: small, just under a power of two (almost no rejections with
+// the debiased modulo), just over one, and huge ranges where the 64 bit path
+// rejects close to half of the candidates
+SINGLE(b_random_range_10, uint64_t, random_range(&c->state, 10))
+SINGLE(b_random_range_1000, uint64_t, random_range(&c->state, 1000))
+SINGLE(b_random_range_2p32m1, uint64_t, random_range(&c->state, 0xffffffff))
+SINGLE(b_random_range_2p32p1, uint64_t, random_range(&c->state, 0x100000001))
+SINGLE(b_random_range_2p63p1, uint64_t, random_range(&c->state, ((uint64_t)1 << 63) + 1))
+SINGLE(b_random_range_max, uint64_t, random_range(&c->state, UINT64_MAX))
+FILL(b_random_fill_range_10, uint64_t, random_fill_range(&c->state, out, n, 10))
+FILL(b_random_fill_range_2p32m1, uint64_t, random_fill_range(&c->state, out, n, 0xffffffff))
+FILL(b_random_fill_range_2p63p1, uint64_t, random_fill_range(&c->state, out, n, ((uint64_t)1 << 63) + 1))
+SINGLE(b_random_range_u32_10, uint32_t, random_range_u32(&c->state, 10))
+SINGLE(b_random_range_u32_2p31p1, uint32_t, random_range_u32(&c->state, 0x80000001))
+FILL(b_random_fill_range_u32_10, uint32_t, random_fill_range_u32(&c->state, out, n, 10))
+FILL(b_random_fill_range_u32_2p31p1, uint32_t, random_fill_range_u32(&c->state, out, n, 0x80000001))
+SINGLE(b_random_int_dice, int, random_int(&c->state, 1, 6))
+SINGLE(b_random_int_full, int, random_int(&c->state, INT_MIN, INT_MAX))
+SINGLE(b_random_alias_sample, uint32_t, random_alias_sample(&c->state, &c->alias))
+FILL(b_random_fill_alias, uint32_t, random_fill_alias(&c->state, &c->alias, out, n))
+FILL(b_random_shuffle_u32, uint32_t, (void)out; random_shuffle_u32(&c->state, c->shuffle, n))
+
+// Uniform floats
+SINGLE(b_random_float_01, float, random_float_01(&c->state))
+SINGLE(b_random_double_01, double, random_double_01(&c->state))
+SINGLE(b_random_float_01_fast, float, random_float_01_fast(&c->state))
+SINGLE(b_random_double_01_fast, double, random_double_01_fast(&c->state))
+SINGLE(b_random_float_01_full, float, random_float_01_full(&c->state))
+SINGLE(b_random_double_01_full, double, random_double_01_full(&c->state))
+STEPS(b_random_float2_01, float, 2, random_float2_01(&c->state, out + i))
+SINGLE(b_random_float, float, random_float(&c->state, -1.0f, 1.0f))
+SINGLE(b_random_double, double, random_double(&c->state, -1.0, 1.0))
+FILL(b_random_fill_float_01, float, random_fill_float_01(&c->state, out, n))
+FILL(b_random_fill_double_01, double, random_fill_double_01(&c->state, out, n))
+FILL(b_random_fill_float, float, random_fill_float(&c->state, out, n, -1.0f, 1.0f))
+FILL(b_random_fill_double, double, random_fill_double(&c->state, out, n, -1.0, 1.0))
+SINGLE(b_random_buffer_double_01, double, random_buffer_double_01(&c->buffer))
+SINGLE(b_rf_float_01, float, rf_float_01(&c->state))
+SINGLE(b_rf_double_01, double, rf_double_01(&c->state))
+SINGLE(b_rf_float_01_fast, float, rf_float_01_fast(&c->state))
+SINGLE(b_rf_double_01_fast, double, rf_double_01_fast(&c->state))
+SINGLE(b_rf_float_01_full, float, rf_float_01_full(&c->state))
+SINGLE(b_rf_double_01_full, double, rf_double_01_full(&c->state))
+STEPS(b_rf_float2_01, float, 2, rf_float2_01(&c->state, out + i))
+FILL(b_rf_fill_float_01, float, rf_fill_float_01(&c->state, out, n))
+FILL(b_rf_fill_double_01, double, rf_fill_double_01(&c->state, out, n))
+FILL(b_rf_fill_float_01_x4, float, rf_fill_float_01_x4(&c->x4, out, n))
+FILL(b_rf_fill_float_01_x8, float, rf_fill_float_01_x8(&c->x8, out, n))
+FILL(b_rf_fill_double_01_x4, double, rf_fill_double_01_x4(&c->x4, out, n))
+FILL(b_rf_fill_double_01_x8, double, rf_fill_double_01_x8(&c->x8, out, n))
+FILL(b_rf_fill_float_01_x4_dispatch, float, rf_fill_float_01_x4_dispatch(&c->x4, out, n))
+FILL(b_rf_fill_float_01_x8_dispatch, float, rf_fill_float_01_x8_dispatch(&c->x8, out, n))
+FILL(b_rf_fill_double_01_x4_dispatch, double, rf_fill_double_01_x4_dispatch(&c->x4, out, n))
+FILL(b_rf_fill_double_01_x8_dispatch, double, rf_fill_double_01_x8_dispatch(&c->x8, out, n))
+
+// Gaussian samplers: the Ziggurat functions and fills, and the polar method
+// pairs and cached values
+SINGLE(b_random_float_gaussian, float, random_float_gaussian(&c->state, 0.0f, 1.0f))
+SINGLE(b_random_double_gaussian, double, random_double_gaussian(&c->state, 0.0, 1.0))
+FILL(b_random_fill_float_gaussian, float, random_fill_float_gaussian(&c->state, out, n, 0.0f, 1.0f))
+FILL(b_random_fill_double_gaussian, double, random_fill_double_gaussian(&c->state, out, n, 0.0, 1.0))
+STEPS(b_random_float_gaussian_pair, float, 2, random_float_gaussian_pair(&c->state, 0.0f, 1.0f, out + i))
+STEPS(b_random_double_gaussian_pair, double, 2, random_double_gaussian_pair(&c->state, 0.0, 1.0, out + i))
+SINGLE(b_random_float_gaussian_cached, float, random_float_gaussian_cached(&c->state, &c->cache, 0.0f, 1.0f))
+SINGLE(b_random_double_gaussian_cached, double, random_double_gaussian_cached(&c->state, &c->cache, 0.0, 1.0))
+SINGLE(b_rf_float_gaussian, float, rf_float_gaussian(&c->state, 0.0f, 1.0f))
+SINGLE(b_rf_double_gaussian, double, rf_double_gaussian(&c->state, 0.0, 1.0))
+FILL(b_rf_fill_float_gaussian, float, rf_fill_float_gaussian(&c->state, out, n, 0.0f, 1.0f))
+FILL(b_rf_fill_double_gaussian, double, rf_fill_double_gaussian(&c->state, out, n, 0.0, 1.0))
+STEPS(b_rf_float_gaussian_pair, float, 2, rf_float_gaussian_pair(&c->state, 0.0f, 1.0f, out + i))
+STEPS(b_rf_double_gaussian_pair, double, 2, rf_double_gaussian_pair(&c->state, 0.0, 1.0, out + i))
+SINGLE(b_rf_float_gaussian_cached, float, rf_float_gaussian_cached(&c->state, &c->cache, 0.0f, 1.0f))
+SINGLE(b_rf_double_gaussian_cached, double, rf_double_gaussian_cached(&c->state, &c->cache, 0.0, 1.0))
+
+// Other distributions
+SINGLE(b_random_double_exponential, double, random_double_exponential(&c->state, 1.0))
+FILL(b_random_fill_double_exponential, double, random_fill_double_exponential(&c->state, out, n, 1.0))
+SINGLE(b_random_poisson_4, uint64_t, random_poisson(&c->state, 4.0))
+SINGLE(b_random_poisson_1000, uint64_t, random_poisson(&c->state, 1000.0))
+FILL(b_random_fill_poisson_1000, uint64_t, random_fill_poisson(&c->state, out, n, 1000.0))
+SINGLE(b_random_binomial_20, uint64_t, random_binomial(&c->state, 20, 0.3))
+SINGLE(b_random_binomial_10000, uint64_t, random_binomial(&c->state, 10000, 0.3))
+FILL(b_random_fill_binomial_10000, uint64_t, random_fill_binomial(&c->state, out, n, 10000, 0.3))
+
+static const struct {
+    const char *group;
+    const char *name;
+    BenchFunction run;
+    size_t bytes;
+} benches[] = {
+    {"generator", "random_u64", b_random_u64, 8},
+    {"generator", "random_fill_u64", b_random_fill_u64, 8},
+    {"generator", "random_fill_bytes", b_random_fill_bytes, 8},
+    {"generator", "random_buffer_u64", b_random_buffer_u64, 8},
+    {"generator", "random_u64_x4", b_random_u64_x4, 8},
+    {"generator", "random_u64_x8", b_random_u64_x8, 8},
+    {"generator", "random_fill_u64_x4", b_random_fill_u64_x4, 8},
+    {"generator", "random_fill_u64_x8", b_random_fill_u64_x8, 8},
+    {"generator", "random_fill_u64_x4_dispatch", b_random_fill_u64_x4_dispatch, 8},
+    {"generator", "random_fill_u64_x8_dispatch", b_random_fill_u64_x8_dispatch, 8},
+    {"generator", "random_fill_bytes_x8", b_random_fill_bytes_x8, 8},
+    {"generator", "random_fill_bytes_x8_dispatch", b_random_fill_bytes_x8_dispatch, 8},
+    {"generator", "rf__next", b_rf__next, 8},
+    {"generator", "rf__next_x4", b_rf__next_x4, 8},
+    {"generator", "rf__next_x8", b_rf__next_x8, 8},
+    {"generator", "random_at", b_random_at, 8},
+    {"generator", "random_fill_at", b_random_fill_at, 8},
+    {"generator", "random_bits k=1", b_random_bits_1, 4},
+    {"generator", "random_bits k=8", b_random_bits_8, 4},
+    {"generator", "random_bernoulli_mask p=0.3", b_random_bernoulli_mask, 8},
+    {"range", "random_range 10", b_random_range_10, 8},
+    {"range", "random_range 1000", b_random_range_1000, 8},
+    {"range", "random_range 2^32-1", b_random_range_2p32m1, 8},
+    {"range", "random_range 2^32+1", b_random_range_2p32p1, 8},
+    {"range", "random_range 2^63+1", b_random_range_2p63p1, 8},
+    {"range", "random_range 2^64-1", b_random_range_max, 8},
+    {"range", "random_fill_range 10", b_random_fill_range_10, 8},
+    {"range", "random_fill_range 2^32-1", b_random_fill_range_2p32m1, 8},
+    {"range", "random_fill_range 2^63+1", b_random_fill_range_2p63p1, 8},
+    {"range", "random_range_u32 10", b_random_range_u32_10, 4},
+    {"range", "random_range_u32 2^31+1", b_random_range_u32_2p31p1, 4},
+    {"range", "random_fill_range_u32 10", b_random_fill_range_u32_10, 4},
+    {"range", "random_fill_range_u32 2^31+1", b_random_fill_range_u32_2p31p1, 4},
+    {"range", "random_int 1..6", b_random_int_dice, 4},
+    {"range", "random_int INT_MIN..INT_MAX", b_random_int_full, 4},
+    {"range", "random_alias_sample 1000", b_random_alias_sample, 4},
+    {"range", "random_fill_alias 1000", b_random_fill_alias, 4},
+    {"range", "random_shuffle_u32 4096", b_random_shuffle_u32, 4},
+    {"uniform", "random_float_01", b_random_float_01, 4},
+    {"uniform", "random_double_01", b_random_double_01, 8},
+    {"uniform", "random_float_01_fast", b_random_float_01_fast, 4},
+    {"uniform", "random_double_01_fast", b_random_double_01_fast, 8},
+    {"uniform", "random_float_01_full", b_random_float_01_full, 4},
+    {"uniform", "random_double_01_full", b_random_double_01_full, 8},
+    {"uniform", "random_float2_01", b_random_float2_01, 4},
+    {"uniform", "random_float", b_random_float, 4},
+    {"uniform", "random_double", b_random_double, 8},
+    {"uniform", "random_fill_float_01", b_random_fill_float_01, 4},
+    {"uniform", "random_fill_double_01", b_random_fill_double_01, 8},
+    {"uniform", "random_fill_float", b_random_fill_float, 4},
+    {"uniform", "random_fill_double", b_random_fill_double, 8},
+    {"uniform", "random_buffer_double_01", b_random_buffer_double_01, 8},
+    {"uniform", "rf_float_01", b_rf_float_01, 4},
+    {"uniform", "rf_double_01", b_rf_double_01, 8},
+    {"uniform", "rf_float_01_fast", b_rf_float_01_fast, 4},
+    {"uniform", "rf_double_01_fast", b_rf_double_01_fast, 8},
+    {"uniform", "rf_float_01_full", b_rf_float_01_full, 4},
+    {"uniform", "rf_double_01_full", b_rf_double_01_full, 8},
+    {"uniform", "rf_float2_01", b_rf_float2_01, 4},
+    {"uniform", "rf_fill_float_01", b_rf_fill_float_01, 4},
+    {"uniform", "rf_fill_double_01", b_rf_fill_double_01, 8},
+    {"uniform", "rf_fill_float_01_x4", b_rf_fill_float_01_x4, 4},
+    {"uniform", "rf_fill_float_01_x8", b_rf_fill_float_01_x8, 4},
+    {"uniform", "rf_fill_double_01_x4", b_rf_fill_double_01_x4, 8},
+    {"uniform", "rf_fill_double_01_x8", b_rf_fill_double_01_x8, 8},
+    {"uniform", "rf_fill_float_01_x4_dispatch", b_rf_fill_float_01_x4_dispatch, 4},
+    {"uniform", "rf_fill_float_01_x8_dispatch", b_rf_fill_float_01_x8_dispatch, 4},
+    {"uniform", "rf_fill_double_01_x4_dispatch", b_rf_fill_double_01_x4_dispatch, 8},
+    {"uniform", "rf_fill_double_01_x8_dispatch", b_rf_fill_double_01_x8_dispatch, 8},
+    {"gaussian", "random_float_gaussian", b_random_float_gaussian, 4},
+    {"gaussian", "random_double_gaussian", b_random_double_gaussian, 8},
+    {"gaussian", "random_fill_float_gaussian", b_random_fill_float_gaussian, 4},
+    {"gaussian", "random_fill_double_gaussian", b_random_fill_double_gaussian, 8},
+    {"gaussian", "random_float_gaussian_pair", b_random_float_gaussian_pair, 4},
+    {"gaussian", "random_double_gaussian_pair", b_random_double_gaussian_pair, 8},
+    {"gaussian", "random_float_gaussian_cached", b_random_float_gaussian_cached, 4},
+    {"gaussian", "random_double_gaussian_cached", b_random_double_gaussian_cached, 8},
+    {"gaussian", "rf_float_gaussian", b_rf_float_gaussian, 4},
+    {"gaussian", "rf_double_gaussian", b_rf_double_gaussian, 8},
+    {"gaussian", "rf_fill_float_gaussian", b_rf_fill_float_gaussian, 4},
+    {"gaussian", "rf_fill_double_gaussian", b_rf_fill_double_gaussian, 8},
+    {"gaussian", "rf_float_gaussian_pair", b_rf_float_gaussian_pair, 4},
+    {"gaussian", "rf_double_gaussian_pair", b_rf_double_gaussian_pair, 8},
+    {"gaussian", "rf_float_gaussian_cached", b_rf_float_gaussian_cached, 4},
+    {"gaussian", "rf_double_gaussian_cached", b_rf_double_gaussian_cached, 8},
+    {"distribution", "random_double_exponential", b_random_double_exponential, 8},
+    {"distribution", "random_fill_double_exponential", b_random_fill_double_exponential, 8},
+    {"distribution", "random_poisson 4", b_random_poisson_4, 8},
+    {"distribution", "random_poisson 1000", b_random_poisson_1000, 8},
+    {"distribution", "random_fill_poisson 1000", b_random_fill_poisson_1000, 8},
+    {"distribution", "random_binomial 20 0.3", b_random_binomial_20, 8},
+    {"distribution", "random_binomial 10000 0.3", b_random_binomial_10000, 8},
+    {"distribution", "random_fill_binomial 10000 0.3", b_random_fill_binomial_10000, 8},
+};
+
+#define BENCH_COUNT (sizeof(benches) / sizeof(benches[0]))
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Pins the calling thread to cpu, or to the CPU it runs on if cpu is negative.
+// Returns the CPU, or -1 where pinning isn't supported.
+static int pin_thread(int cpu) {
+#ifdef __linux__
+    if (cpu < 0) {
+        cpu = sched_getcpu();
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0 ? cpu : -1;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+// Runs one benchmark and stores the best and median ns per value
+static void measure(Context *c, BenchFunction run, double min_time, double *best, double *median) {
+    double ns[REPEATS];
+
+    // Warm up the caches, tables and branch predictors, and find how many
+    // batches take at least min_time
+    size_t batches = 1;
+    for (;;) {
+        const double start = now();
+        for (size_t i = 0; i < batches; i++) {
+            run(c);
+        }
+        const double elapsed = now() - start;
+        if (elapsed >= min_time) {
+            break;
+        }
+        batches = elapsed > 0.0 && min_time / elapsed < 1e6 ? (size_t)(batches * (min_time / elapsed) * 1.1) + 1
+                                                             : batches * 10;
+    }
+
+    for (int r = 0; r < REPEATS; r++) {
+        const double start = now();
+        for (size_t i = 0; i < batches; i++) {
+            run(c);
+        }
+        ns[r] = (now() - start) * 1e9 / ((double)batches * BATCH);
+    }
+    qsort(ns, REPEATS, sizeof(double), compare_double);
+    *best = ns[0];
+    *median = ns[REPEATS / 2];
+}
+
+static int selected(const char *name, int filters, char **filter) {
+    if (!filters) {
+        return 1;
+    }
+    for (int i = 0; i < filters; i++) {
+        if (strstr(name, filter[i])) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int usage(void) {
+    fprintf(stderr, "usage: bench [--json] [--cpu N] [--time SECONDS] [FILTER...]\n");
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+    int json = 0;
+    int cpu = -1;
+    double min_time = 0.05;
+    char **filter = (char **)calloc((size_t)argc, sizeof(char *));
+    int filters = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) {
+            cpu = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--time") == 0 && i + 1 < argc) {
+            min_time = atof(argv[++i]);
+        } else if (argv[i][0] == '-') {
+            return usage();
+        } else {
+            filter[filters++] = argv[i];
+        }
+    }
+
+    cpu = pin_thread(cpu);
+
+    static Context c;
+    random_seed(&c.state, 1);
+    random_seed_x4(&c.x4, 2);
+    random_seed_x8(&c.x8, 3);
+    random_buffer_init(&c.buffer, 4);
+    c.threshold = random_bernoulli_threshold(0.3);
+    double weights[1000];
+    for (size_t i = 0; i < 1000; i++) {
+        weights[i] = 1.0 + (double)(i % 17);
+    }
+    if (random_alias_init(&c.alias, weights, 1000) != 0) {
+        return EXIT_FAILURE;
+    }
+    for (uint32_t i = 0; i < BATCH; i++) {
+        c.shuffle[i] = i;
+    }
+
+    if (json) {
+        printf("{\n  \"cpu\": %d,\n  \"dispatch\": \"%s\",\n  \"batch\": %d,\n  \"results\": [", cpu,
+               random_dispatch_target(), BATCH);
+    } else {
+        printf("cpu %d, _dispatch uses %s, %d values per batch\n\n", cpu, random_dispatch_target(), BATCH);
+        printf("%-14s %-32s %10s %10s %8s\n", "group", "name", "ns/value", "median", "GB/s");
+    }
+
+    int first = 1;
+    for (size_t b = 0; b < BENCH_COUNT; b++) {
+        if (!selected(benches[b].name, filters, filter)) {
+            continue;
+        }
+        double best;
+        double median;
+        measure(&c, benches[b].run, min_time, &best, &median);
+        const double gbps = (double)benches[b].bytes / best;
+        if (json) {
+            printf("%s\n    {\"group\": \"%s\", \"name\": \"%s\", \"ns_per_value\": %.4f, \"ns_median\": %.4f, "
+                   "\"gb_per_s\": %.3f, \"bytes_per_value\": %zu}",
+                   first ? "" : ",", benches[b].group, benches[b].name, best, median, gbps, benches[b].bytes);
+        } else {
+            printf("%-14s %-32s %10.3f %10.3f %8.2f\n", benches[b].group, benches[b].name, best, median, gbps);
+        }
+        fflush(stdout);
+        first = 0;
+    }
+    if (json) {
+        printf("\n  ]\n}\n");
+    }
+
+    random_alias_free(&c.alias);
+    free(filter);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,278 @@
+// Multithreaded scaling of the three ways to give each thread its own state:
+//
+//   packed        an array of RandomState, where neighboring threads share a
+//                 cache line (RandomState is 32 bytes)
+//   aligned       an array of RandomStateAligned from random_alloc_states, one
+//                 state per cache line
+//   thread_local  a thread local RandomState in each thread
+//
+// Usage: threads [--json] [--threads N] [--batches B] [--no-pin]
+//
+// Each layout is run with 1 to N threads (the number of online CPUs by
+// default). Every thread calls random_u64 B times BATCH times (2000 by
+// default) and stores the values, and thread i is pinned to CPU i unless
+// --no-pin is passed. The states are seeded with jumps, so the streams don't
+// overlap. The aggregate throughput is the number of values from all threads
+// divided by the wall time from the start of the first thread to the end of
+// the last one. The latency percentiles are those of the ns per call in single
+// batches, over the batches of every thread, so p99 shows the threads that are
+// slowed down by sharing lines, or by other threads on the same core when
+// there are more threads than CPUs. --json prints the results as a JSON object
+// instead of a table.
+
+#define _GNU_SOURCE
+#include "random.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BATCH 1024
+#define SEED 0x243f6a8885a308d3
+
+#if defined(__GNUC__)
+#define THREAD_LOCAL __thread
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+enum { PACKED, ALIGNED, TLS, LAYOUTS };
+
+static const char *const layout_names[LAYOUTS] = {"packed", "aligned", "thread_local"};
+
+static THREAD_LOCAL RandomState tls_state;
+
+typedef struct {
+    int layout;
+    int index;
+    int cpu;
+    size_t batches;
+    RandomState *state;  // The packed or aligned state, unused for thread_local
+    pthread_barrier_t *barrier;
+    double *ns;  // ns per call of each batch
+    double start;
+    double end;
+    uint64_t sink;
+} Worker;
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + 1e-9 * (double)t.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Pins the calling thread to cpu. Returns 0, or -1 where pinning isn't
+// supported or fails.
+static int pin_thread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? 0 : -1;
+#else
+    (void)cpu;
+    return -1;
+#endif
+}
+
+// The values go to out, which may alias the state, so every call loads and
+// stores the state like code that keeps it in shared memory would
+static void run_batch(RandomState *state, uint64_t *out) {
+    for (size_t i = 0; i < BATCH; i++) {
+        out[i] = random_u64(state);
+    }
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = (Worker *)arg;
+    if (w->cpu >= 0) {
+        pin_thread(w->cpu);
+    }
+
+    RandomState *state = w->state;
+    if (w->layout == TLS) {
+        random_seed(&tls_state, SEED);
+        for (int i = 0; i < w->index; i++) {
+            random_jump(&tls_state);
+        }
+        state = &tls_state;
+    }
+
+    uint64_t *out = (uint64_t *)malloc(BATCH * sizeof(uint64_t));
+    if (!out) {
+        abort();
+    }
+    uint64_t sink = 0;
+
+    pthread_barrier_wait(w->barrier);
+    w->start = now();
+    for (size_t b = 0; b < w->batches; b++) {
+        const double start = now();
+        run_batch(state, out);
+        w->ns[b] = (now() - start) * 1e9 / BATCH;
+        sink ^= out[b % BATCH];
+    }
+    w->end = now();
+
+    w->sink = sink;
+    free(out);
+    return NULL;
+}
+
+typedef struct {
+    double values_per_s;
+    double p50;
+    double p90;
+    double p99;
+} Result;
+
+static double percentile(const double *sorted, size_t n, double p) {
+    return sorted[(size_t)(p * (double)(n - 1) + 0.5)];
+}
+
+static int run(int layout, int threads, size_t batches, int pin, Result *result) {
+    pthread_t *ids = (pthread_t *)calloc((size_t)threads, sizeof(pthread_t));
+    Worker *workers = (Worker *)calloc((size_t)threads, sizeof(Worker));
+    double *ns = (double *)malloc((size_t)threads * batches * sizeof(double));
+    RandomState *packed = NULL;
+    RandomStateAligned *aligned = NULL;
+    if (layout == PACKED) {
+        packed = (RandomState *)malloc((size_t)threads * sizeof(RandomState));
+        if (packed) {
+            random_seed(&packed[0], SEED);
+            for (int i = 1; i < threads; i++) {
+                packed[i] = packed[i - 1];
+                random_jump(&packed[i]);
+            }
+        }
+    } else if (layout == ALIGNED) {
+        aligned = random_alloc_states((size_t)threads, SEED);
+    }
+    if (!ids || !workers || !ns || (layout == PACKED && !packed) || (layout == ALIGNED && !aligned)) {
+        free(ids);
+        free(workers);
+        free(ns);
+        free(packed);
+        random_free_states(aligned);
+        return -1;
+    }
+
+    pthread_barrier_t barrier;
+    pthread_barrier_init(&barrier, NULL, (unsigned)threads + 1);
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 0; i < threads; i++) {
+        Worker *w = &workers[i];
+        w->layout = layout;
+        w->index = i;
+        w->cpu = pin && cpus > 0 ? (int)(i % cpus) : -1;
+        w->batches = batches;
+        w->state = layout == PACKED ? &packed[i] : layout == ALIGNED ? &aligned[i].state : NULL;
+        w->barrier = &barrier;
+        w->ns = ns + (size_t)i * batches;
+        // The barrier would wait forever for a thread that didn't start
+        if (pthread_create(&ids[i], NULL, worker_main, w) != 0) {
+            abort();
+        }
+    }
+
+    // The wall time is taken by the workers, since the main thread may not
+    // run again until they are done when there are more threads than CPUs
+    pthread_barrier_wait(&barrier);
+    for (int i = 0; i < threads; i++) {
+        pthread_join(ids[i], NULL);
+    }
+    pthread_barrier_destroy(&barrier);
+    double start = workers[0].start;
+    double end = workers[0].end;
+    for (int i = 1; i < threads; i++) {
+        start = workers[i].start < start ? workers[i].start : start;
+        end = workers[i].end > end ? workers[i].end : end;
+    }
+    const double elapsed = end - start;
+
+    const size_t samples = (size_t)threads * batches;
+    qsort(ns, samples, sizeof(double), compare_double);
+    result->values_per_s = (double)samples * BATCH / elapsed;
+    result->p50 = percentile(ns, samples, 0.50);
+    result->p90 = percentile(ns, samples, 0.90);
+    result->p99 = percentile(ns, samples, 0.99);
+
+    free(ids);
+    free(workers);
+    free(ns);
+    free(packed);
+    random_free_states(aligned);
+    return 0;
+}
+
+int main(int argc, char **argv) {
+    int json = 0;
+    int pin = 1;
+    long max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t batches = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--json") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "--no-pin") == 0) {
+            pin = 0;
+        } else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            max_threads = atol(argv[++i]);
+        } else if (strcmp(argv[i], "--batches") == 0 && i + 1 < argc) {
+            batches = (size_t)atol(argv[++i]);
+        } else {
+            fprintf(stderr, "usage: threads [--json] [--threads N] [--batches B] [--no-pin]\n");
+            return EXIT_FAILURE;
+        }
+    }
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+    if (batches < 1) {
+        batches = 1;
+    }
+
+    if (json) {
+        printf("{\n  \"cpus\": %ld,\n  \"pinned\": %s,\n  \"cache_line\": %d,\n  \"batch\": %d,\n  \"results\": [",
+               sysconf(_SC_NPROCESSORS_ONLN), pin ? "true" : "false", RANDOM_CACHE_LINE, BATCH);
+    } else {
+        printf("%ld CPUs, %s, %d byte cache lines, %d values per batch\n\n", sysconf(_SC_NPROCESSORS_ONLN),
+               pin ? "pinned" : "not pinned", RANDOM_CACHE_LINE, BATCH);
+        printf("%-14s %7s %12s %8s %10s %10s %10s\n", "layout", "threads", "Mvalues/s", "GB/s", "p50 ns", "p90 ns",
+               "p99 ns");
+    }
+
+    int first = 1;
+    for (int layout = 0; layout < LAYOUTS; layout++) {
+        for (int threads = 1; threads <= max_threads; threads++) {
+            Result r;
+            if (run(layout, threads, batches, pin, &r) != 0) {
+                fprintf(stderr, "threads: out of memory\n");
+                return EXIT_FAILURE;
+            }
+            const double gbps = r.values_per_s * sizeof(uint64_t) * 1e-9;
+            if (json) {
+                printf("%s\n    {\"layout\": \"%s\", \"threads\": %d, \"values_per_s\": %.0f, \"gb_per_s\": %.3f, "
+                       "\"p50_ns\": %.4f, \"p90_ns\": %.4f, \"p99_ns\": %.4f}",
+                       first ? "" : ",", layout_names[layout], threads, r.values_per_s, gbps, r.p50, r.p90, r.p99);
+            } else {
+                printf("%-14s %7d %12.1f %8.2f %10.3f %10.3f %10.3f\n", layout_names[layout], threads,
+                       r.values_per_s * 1e-6, gbps, r.p50, r.p90, r.p99);
+            }
+            fflush(stdout);
+            first = 0;
+        }
+    }
+    if (json) {
+        printf("\n  ]\n}\n");
+    }
+    return EXIT_SUCCESS;
+}
@@ -1,6 +1,6 @@
 /* random.h, a C header for fast and easy random number generation.
 
-Version: 1.2
+Version: 1.3
 Author: Erik Fast (fasterik.net)
 License: CC0
 
@@ -27,30 +27,374 @@ API:
 // Initialize the PRNG with a 64 bit seed
 void random_seed(RandomState *state, uint64_t seed);
 
+// Advance the state by 2^128 or 2^192 steps, for generating non-overlapping
+// sequences, e.g. one per thread
+void random_jump(RandomState *state);
+void random_long_jump(RandomState *state);
+
+// Seed child from parent and advance parent, so both can be used (and split)
+// independently
+void random_split(RandomState *parent, RandomState *child);
+
+// Allocate an array of n states on separate cache lines, where state i starts i
+// jumps after a state seeded with seed. Returns NULL if the allocation fails.
+RandomStateAligned *random_alloc_states(size_t n, uint64_t seed);
+void random_free_states(RandomStateAligned *states);
+
+// States in structure-of-arrays layout for GPUs, see below
+void random_seed_soa(RandomStateSoA *soa, uint64_t seed);
+void random_load_soa(const RandomStateSoA *soa, size_t i, RandomState *state);
+void random_store_soa(RandomStateSoA *soa, size_t i, const RandomState *state);
+
+// Save and restore states in a portable format of RANDOM_STATES_BYTES(n)
+// bytes. The load functions return 0 on success and -1 if the data isn't a
+// valid checkpoint. states points to n states that are stride bytes apart,
+// where stride is a multiple of 8 and at least sizeof(RandomState).
+void random_state_save(const RandomState *state, unsigned char out[RANDOM_STATE_BYTES]);
+int random_state_load(RandomState *state, const unsigned char in[RANDOM_STATE_BYTES]);
+void random_states_save(const void *states, size_t n, size_t stride, unsigned char *out);
+int random_states_load(void *states, size_t n, size_t stride, const unsigned char *in);
+void random_state_save_x4(const RandomStateX4 *state, unsigned char out[RANDOM_STATES_BYTES(4)]);
+int random_state_load_x4(RandomStateX4 *state, const unsigned char in[RANDOM_STATES_BYTES(4)]);
+void random_state_save_x8(const RandomStateX8 *state, unsigned char out[RANDOM_STATES_BYTES(8)]);
+int random_state_load_x8(RandomStateX8 *state, const unsigned char in[RANDOM_STATES_BYTES(8)]);
+
 // Generate a random unsigned 64 bit integer
 uint64_t random_u64(RandomState *state);
+void random_fill_u64(RandomState *state, uint64_t *out, size_t n);
+
+// Fill len bytes at dst, which doesn't have to be aligned
+void random_fill_bytes(RandomState *state, void *dst, size_t len);
+
+// Generate k random bits (1 <= k <= 32) from a reservoir of unused bits of
+// earlier outputs. The reservoir has to be zero initialized.
+uint32_t random_bits(RandomState *state, RandomBits *reservoir, unsigned k);
+
+// Return 1 with probability p and 0 otherwise, with p converted once by
+// random_bernoulli_threshold. The mask version returns 64 independent outcomes,
+// one per bit.
+uint64_t random_bernoulli_threshold(double p);
+int random_bernoulli(RandomState *state, uint64_t threshold);
+uint64_t random_bernoulli_mask(RandomState *state, uint64_t threshold);
 
 // Generate 0 <= x < range
 uint64_t random_range(RandomState *state, uint64_t range);
+void random_fill_range(RandomState *state, uint64_t *out, size_t n, uint64_t range);
+uint32_t random_range_u32(RandomState *state, uint32_t range);
+void random_fill_range_u32(RandomState *state, uint32_t *out, size_t n, uint32_t range);
 
 // Generate lower <= x <= upper
 int random_int(RandomState *state, int lower, int upper);
 
+// Shuffle n elements of elem_size bytes in place
+void random_shuffle(RandomState *state, void *base, size_t n, size_t elem_size);
+void random_shuffle_u32(RandomState *state, uint32_t *base, size_t n);
+void random_shuffle_u64(RandomState *state, uint64_t *base, size_t n);
+void random_shuffle_ptr(RandomState *state, void **base, size_t n);
+
+// Write k distinct indices 0 <= x < n to out, in no particular order (k <= n)
+void random_sample_indices(RandomState *state, size_t *out, size_t k, size_t n);
+
+// Reservoir sampling of k items from a stream. Returns the slot 0 <= x < k to
+// store item i in, or k if the item should be skipped.
+size_t random_reservoir_slot(RandomState *state, size_t i, size_t k);
+
+// Sample indices 0 <= x < n with probabilities proportional to the weights.
+// random_alias_init returns 0 on success, and -1 if the weights are invalid or
+// the allocation fails.
+int random_alias_init(RandomAliasTable *table, const double *weights, size_t n);
+void random_alias_free(RandomAliasTable *table);
+uint32_t random_alias_sample(RandomState *state, const RandomAliasTable *table);
+void random_fill_alias(RandomState *state, const RandomAliasTable *table, uint32_t *out, size_t n);
+
 // Generate floating point 0 <= x < 1
 float random_float_01(RandomState *state);
 double random_double_01(RandomState *state);
+void random_fill_float_01(RandomState *state, float *out, size_t n);
+void random_fill_double_01(RandomState *state, double *out, size_t n);
+
+// Generate two floats 0 <= x < 1 from a single 64 bit output
+void random_float2_01(RandomState *state, float out[2]);
+
+// Variants of random_float_01 and random_double_01: _fast builds the value from
+// random mantissa bits, which can be faster but has one bit less precision.
+// _full can return every float or double in the range, including tiny ones.
+float random_float_01_fast(RandomState *state);
+double random_double_01_fast(RandomState *state);
+float random_float_01_full(RandomState *state);
+double random_double_01_full(RandomState *state);
 
 // Generate floating point lower <= x < upper
 float random_float(RandomState *state, float lower, float upper);
 double random_double(RandomState *state, double lower, double upper);
+void random_fill_float(RandomState *state, float *out, size_t n, float lower, float upper);
+void random_fill_double(RandomState *state, double *out, size_t n, double lower, double upper);
+
+// Draw values from a buffer of RANDOM_BUFFER_SIZE pre-generated outputs
+void random_buffer_init(RandomBuffer *buffer, uint64_t seed);
+uint64_t random_buffer_u64(RandomBuffer *buffer);
+uint64_t random_buffer_range(RandomBuffer *buffer, uint64_t range);
+float random_buffer_float_01(RandomBuffer *buffer);
+double random_buffer_double_01(RandomBuffer *buffer);
+
+// Multi-lane versions with 4 or 8 independent xoshiro256++ streams
+void random_seed_x4(RandomStateX4 *state, uint64_t seed);
+void random_seed_x8(RandomStateX8 *state, uint64_t seed);
+void random_u64_x4(RandomStateX4 *state, uint64_t out[4]);
+void random_u64_x8(RandomStateX8 *state, uint64_t out[8]);
+void random_fill_u64_x4(RandomStateX4 *state, uint64_t *out, size_t n);
+void random_fill_u64_x8(RandomStateX8 *state, uint64_t *out, size_t n);
+void random_fill_bytes_x4(RandomStateX4 *state, void *dst, size_t len);
+void random_fill_bytes_x8(RandomStateX8 *state, void *dst, size_t len);
+
+// Same as the four functions above, but pick the fastest instruction set the
+// CPU supports at run time. They are only compiled in the file that defines
+// RANDOM_IMPLEMENTATION. random_dispatch_target returns the name of the
+// instruction set that was picked.
+void random_fill_u64_x4_dispatch(RandomStateX4 *state, uint64_t *out, size_t n);
+void random_fill_u64_x8_dispatch(RandomStateX8 *state, uint64_t *out, size_t n);
+void random_fill_bytes_x4_dispatch(RandomStateX4 *state, void *dst, size_t len);
+void random_fill_bytes_x8_dispatch(RandomStateX8 *state, void *dst, size_t len);
+const char *random_dispatch_target(void);
 
 // Sample a normal distribution with the given mean and standard deviation
 float random_float_gaussian(RandomState *state, float mu, float sigma);
 double random_double_gaussian(RandomState *state, double mu, double sigma);
+void random_fill_float_gaussian(RandomState *state, float *out, size_t n, float mu, float sigma);
+void random_fill_double_gaussian(RandomState *state, double *out, size_t n, double mu, double sigma);
+
+// Sample two independent values from a normal distribution with the polar
+// method, out[0] and out[1] use the same mean and standard deviation
+void random_float_gaussian_pair(RandomState *state, float mu, float sigma, float out[2]);
+void random_double_gaussian_pair(RandomState *state, double mu, double sigma, double out[2]);
+
+// Same as above, but keeps the second value of each pair in the cache and
+// returns it on the next call. The cache has to be zero initialized.
+float random_float_gaussian_cached(RandomState *state, RandomGaussianCache *cache, float mu, float sigma);
+double random_double_gaussian_cached(RandomState *state, RandomGaussianCache *cache, double mu, double sigma);
+
+// Sample an exponential distribution with the given rate
+double random_double_exponential(RandomState *state, double lambda);
+void random_fill_double_exponential(RandomState *state, double *out, size_t n, double lambda);
+
+// Sample a Poisson distribution with the given mean
+uint64_t random_poisson(RandomState *state, double lambda);
+void random_fill_poisson(RandomState *state, uint64_t *out, size_t n, double lambda);
+
+// Sample the number of successes in n trials with probability p, the fill
+// version writes count values
+uint64_t random_binomial(RandomState *state, uint64_t n, double p);
+void random_fill_binomial(RandomState *state, uint64_t *out, size_t count, uint64_t n, double p);
+
+// Counter-based generator: value number counter of the stream with the given
+// key, and the n values starting there
+uint64_t random_at(uint64_t key, uint64_t counter);
+void random_fill_at(uint64_t key, uint64_t counter, uint64_t *out, size_t n);
+
+// Only with RANDOM_STATS, see below. The counters are per thread.
+// random_stats_dump prints the given counters, or the calling thread's if stats
+// is NULL.
+void random_stats_get(RandomStats *stats);
+void random_stats_reset(void);
+void random_stats_dump(FILE *file, const RandomStats *stats);
+
+
+The random_fill_* functions write n values to out. They work on a local copy of
+the state so it can stay in registers for the whole buffer, and produce the same
+sequence as calling the matching single value function n times, except where
+noted. The float fills use both halves of each output, and match calling
+random_float2_01 n / 2 times, followed by one random_float_01 call if n is odd.
+The Gaussian fills work in blocks: they first take the fast path of the Ziggurat
+method for the whole block without branching, and then run the slow path for the
+few values that need it. The distribution is the same, but the values differ
+from calling the single value function.
+
+random_fill_bytes writes the outputs in little endian byte order, so the bytes
+are the same on every machine and match writing random_fill_u64 to the buffer on
+little endian ones. The 8 byte stores compile to single unaligned stores, which
+run at the same speed as aligned ones on current x86 and ARM cores, so the
+bytes don't depend on the alignment of dst either. The last output is only used
+for the tail if len isn't a multiple of 8. The multi-lane versions write 32 or
+64 bytes per step. random_bits spends one output per 64 bits, e.g. 64 coin flips
+with k = 1, or 21 Bernoulli(1/8) trials by comparing 3 bit values with 0. When
+fewer than k bits are left they are discarded and a new output is drawn.
+
+random_bernoulli gives exactly the same results as random_double_01(state) < p,
+but with an integer compare instead of the conversion. random_bernoulli_mask
+compares 64 uniform numbers with p bit by bit, using one output per bit until
+every lane is decided or the remaining bits of p are zero. That is 1 output for
+p = 0.5, at most k outputs for p = 2^-k, and about 7 on average for other values
+of p, compared to 64 outputs for 64 calls to random_bernoulli. The outcomes have the
+same probability as random_bernoulli, but are a different sequence.
+
+random_float_01 and random_double_01 return multiples of 2^-24 and 2^-53. The _fast
+versions set the exponent bits of 1.0 and subtract 1, giving multiples of 2^-23
+and 2^-52. This trades one bit of precision for skipping the int to float
+conversion, which helps on targets where that conversion is slow or doesn't
+vectorize; on x86-64 the difference is small. The _full versions pick the
+exponent from the leading zeros of an extra output, so values below 2^-53 are
+sampled as finely as the type allows, which matters when the result is used in
+e.g. log(x) or 1 / x. They take at least two outputs per value.
+
+The shuffle functions use the Fisher-Yates method. They draw the indices for
+32 swaps at a time, prefetch the elements to be swapped and then swap them,
+which hides most of the cache misses on large arrays. While the remaining length
+fits in 32 bits the indices use random_range_u32 on each half of an output, so
+the results differ from a loop over random_int. random_sample_indices uses
+Floyd's algorithm, which takes O(k^2) time, so it's meant for small k. For
+large k, shuffling an index array and taking the first k elements is faster.
+
+RandomAliasTable is built once in O(n) time with Vose's alias method, after
+which each sample takes one output, a table lookup and a compare.
+random_fill_alias gives the same results, but generates the outputs in blocks
+with random_fill_u64, away from the table lookups, and only divides once per
+call. The weights have to be non-negative and finite, with a positive sum. The
+thresholds are stored as 32 bit fixed point numbers next to the aliases, rather
+than in a separate array, so that a sample only touches one cache line of a
+large table.
+
+The exponential distribution uses the Ziggurat method with its own tables, in
+the same layout as the Gaussian ones. The Poisson and binomial samplers pick a
+method depending on the parameters: inversion for small means, and Hormann's
+transformed rejection (PTRS and BTRS) for large ones, which takes a roughly
+constant time. Their fill functions compute the constants for the parameters
+once per call.
+
+random_at doesn't use a RandomState. It computes any value of a stream directly
+from the key and the position, using the Philox4x32-10 generator, which passes
+the same statistical tests as xoshiro256++. This lets any number of threads
+generate any part of a stream without sharing state or jumping, with the same
+results regardless of how the work is split up. Each Philox block gives two
+values, so random_fill_at is about twice as fast per value as random_at, but
+both are several times slower than random_u64.
+
+RandomBuffer keeps a cache line aligned block of outputs, which is refilled
+with random_fill_u64 when it runs out, so drawing a value is usually just a
+load and an index increment. It produces the same sequence as a RandomState
+seeded with the same seed. The block size is set by defining RANDOM_BUFFER_SIZE
+before including this file (256 by default), and has to be the same in every
+file that shares a RandomBuffer.
+
+random_jump and random_long_jump give a fixed number of streams that are
+guaranteed not to overlap, which is the best choice for a known set of threads.
+random_split is meant for task schedulers that split streams recursively, where
+jumps would make streams overlap. The chance of two split streams overlapping in
+practice is negligible, since the period is 2^256 - 1. RandomState is 32 bytes,
+so two states in an array share a cache line, which slows down threads that use
+adjacent states. RandomStateAligned pads the state to a full cache line to
+avoid this, and random_alloc_states allocates aligned arrays of them. The line
+size is 64 bytes, unless RANDOM_CACHE_LINE is defined as something else (e.g.
+128, for CPUs that prefetch pairs of lines) before including this file. It has
+to be a power of two of at least 32.
+
+Under CUDA and HIP, the generator, jumps and uniform conversions are __host__
+__device__ functions: random_seed, random_u64, random_jump, random_long_jump,
+random_split, the _01 and _01_fast functions and random_float2_01. They give bit
+for bit the same results on the device as on the host. random_float and
+random_double do as well, as long as neither compiler fuses the multiply and add
+(e.g. nvcc -fmad=false). The macro RANDOM_HOST_DEVICE holds the qualifiers, and
+can be defined before including this file for other compilers. The Gaussian
+functions stay host only, since the Ziggurat tables are host data and the device
+math library doesn't round like the host one. RandomStateSoA stores n states as
+four arrays of n words, so that the states of neighboring threads are next to
+each other in device memory. Seed it on the host with random_seed_soa, where
+state i starts i jumps after the seed, and copy it to the device. In a kernel,
+random_load_soa copies state i into a local state, and random_store_soa writes
+it back.
+
+Saved states use a fixed format: an 8 byte tag followed by the four state words
+of each state, in little endian byte order, so checkpoints can be moved between
+machines. A multi-lane state is saved as one state per lane. On little endian
+machines the state words are stored as they are in memory, so the load functions
+compile to a plain copy plus the validity checks.
+
+The multi-lane states store the lanes in structure-of-arrays layout, so one
+step of every lane maps onto a few vector instructions. AVX2 and AVX-512 are
+used when the compiler targets them (e.g. -mavx2 or -march=native), otherwise
+the lanes are stepped in a plain loop that the compiler is free to vectorize
+for the target, e.g. with NEON. Lane 0 produces the same sequence as a
+RandomState seeded with the same seed, and every following lane starts one jump
+after the previous one. The fill functions write one step of every lane at a
+time, lane by lane. If n isn't a multiple of the lane count, the outputs of the
+last step that don't fit are discarded.
+
+The _dispatch functions are for binaries that run on several kinds of x86 CPUs
+and can't be compiled for AVX2 or AVX-512. To use them, define
+RANDOM_IMPLEMENTATION in one C or C++ file before including random.h (and before
+random_float.h, if that file includes both):
+
+    #define RANDOM_IMPLEMENTATION
+    #include "random.h"
+
+With GCC and Clang on x86, that file gets AVX2 and AVX-512 versions of the fill
+loops, compiled with target attributes, and a constructor picks the best one
+for the CPU at startup. The results are the same on every CPU. Elsewhere the
+functions call the inline versions, which use whatever the compiler targets,
+e.g. NEON on 64 bit ARM, where it's always available. The inline functions
+don't change, so small calls stay inlined.
+
+Defining RANDOM_STATS in every file that includes random.h or random_float.h,
+e.g. with -DRANDOM_STATS, counts the generator steps, the candidates and
+divisions of the range functions, and the candidates of the Gaussian functions
+and how many values take the slow path of the Ziggurat method. This shows which
+ranges reject often, and how much RANDOM_FAST_RANGE saves. The counters are
+thread local, and defined in the RANDOM_IMPLEMENTATION file (which can include
+either header), so they don't change the size of RandomState. Jumps count as the
+256 steps they take. Counting slows down the fast paths, so it's meant for
+profiling builds. Without RANDOM_STATS there is no counting code at all.
+
+random.h and random_float.h share one implementation of the seeding, jumps,
+multi-lane stepping, conversions and Gaussian sampling, which only differs in
+the output function of the generator. RandomState and RFState are the same type,
+so a state can be used with the functions from both headers, and including both
+only compiles the shared code once. Both headers are still standalone, but they
+have to come from the same release.
+
+random_range and random_int use a debiased modulo, which costs a 64 bit
+division per call. Define RANDOM_FAST_RANGE before including this file to use
+Lemire's nearly divisionless method where the compiler supports 128 bit
+multiplication (GCC, Clang and MSVC on 64 bit targets). The results are just as
+uniform but differ from the default method for the same state. With that
+method, random_fill_range only computes the rejection threshold once per call.
+
+random_range_u32 always uses Lemire's method, since it only needs a 32x32 ->
+64 bit multiply, which every target supports. random_fill_range_u32 takes two
+candidates from each output, so unlike the other fills it doesn't match calling
+random_range_u32 n times.
 
 
 Changelog:
 
+1.3:
+  - Added bulk random_fill_* functions.
+  - Added multi-lane RandomStateX4 and RandomStateX8.
+  - Added random_jump and random_long_jump.
+  - Added RANDOM_FAST_RANGE option for Lemire's bounded integer method.
+  - Switched the Gaussian functions to the Ziggurat method. The previous loop
+    only drew one uniform per sample and didn't produce a normal distribution.
+  - Added polar method random_float_gaussian_pair, random_double_gaussian_pair and
+    the cached versions using RandomGaussianCache.
+  - Made the float conversions use 32 bit int to float conversions.
+  - Added random_fill_float_gaussian and random_fill_double_gaussian.
+  - Shared the generator core with random_float.h, RandomState and RFState are
+    now the same type.
+  - Added RandomBuffer.
+  - Added random_float2_01, the float fills now take two values from each output.
+  - Added random_range_u32 and random_fill_range_u32.
+  - Added random_shuffle, random_sample_indices and random_reservoir_slot.
+  - Added the alias method RandomAliasTable.
+  - Added exponential, Poisson and binomial distributions.
+  - Added the counter-based random_at and random_fill_at.
+  - Added random_split and RandomStateAligned.
+  - Added RANDOM_CACHE_LINE, random_alloc_states and random_free_states.
+  - Fixed random_int for ranges wider than INT_MAX.
+  - Added random_state_save, random_state_load and the bulk versions.
+  - Added the _01_fast and _01_full float and double functions.
+  - Added random_fill_bytes, the multi-lane versions and random_bits.
+  - Added random_bernoulli and random_bernoulli_mask.
+  - Added RANDOM_IMPLEMENTATION and the _dispatch fill functions.
+  - Added the RANDOM_STATS counters.
+  - Added RANDOM_HOST_DEVICE for CUDA and HIP, and RandomStateSoA.
 1.2:
   - Added random_float_gaussian, renamed random_gaussian to random_double_gaussian.
 1.1:
@@ -63,117 +407,2516 @@ Changelog:
 #ifndef RANDOM_H_INCLUDE
 #define RANDOM_H_INCLUDE
 
+#if defined(__AVX2__) || defined(__AVX512F__) || \
+    (defined(RANDOM_IMPLEMENTATION) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+#include <intrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
+#include <assert.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef RANDOM_STATS
+#include <stdio.h>
+#endif
+
+// The core below is shared by random.h and random_float.h. Both headers contain
+// an identical copy of it, so a translation unit that includes both only gets
+// one. xoshiro256++ and xoshiro256+ use the same state transition and only
+// differ in how the output is computed from the state, so the core functions
+// take a plain state array and a scrambler, which is always a constant and gets
+// folded away when they are inlined.
+#ifndef RANDOM__CORE_INCLUDE
+#define RANDOM__CORE_INCLUDE
+#define RANDOM__CORE_VERSION 1
+
+// Qualifies the functions that can also run on a GPU: the generator, jumps and
+// conversions, and the functions built only on those. They don't use static
+// data, so CUDA and HIP can compile them for the device.
+#ifndef RANDOM_HOST_DEVICE
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define RANDOM_HOST_DEVICE __host__ __device__
+#else
+#define RANDOM_HOST_DEVICE
+#endif
+#endif
+
+// Scramblers
+#define RANDOM__PLUS 0       // xoshiro256+, used by random_float.h
+#define RANDOM__PLUS_PLUS 1  // xoshiro256++, used by random.h
 
+// Aligns a variable or struct member to n bytes
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define RANDOM__ALIGN(n) alignas(n)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define RANDOM__ALIGN(n) _Alignas(n)
+#elif defined(__GNUC__)
+#define RANDOM__ALIGN(n) __attribute__((aligned(n)))
+#elif defined(_MSC_VER)
+#define RANDOM__ALIGN(n) __declspec(align(n))
+#else
+#error "No way to align types is known for this compiler"
+#endif
+
+// Alignment of the aligned state types and buffers. Define this as 128 before
+// including the headers on CPUs that fetch cache lines in pairs.
+#ifndef RANDOM_CACHE_LINE
+#define RANDOM_CACHE_LINE 64
+#endif
+
+// State types shared by both headers, see RandomState and RFState
 typedef struct {
     uint64_t s[4];
-} RandomState;
+} Random__State;
+
+// Multi-lane states, s[i][lane] is word i of the given lane's state
+typedef struct {
+    uint64_t s[4][4];
+} Random__StateX4;
+
+typedef struct {
+    uint64_t s[4][8];
+} Random__StateX8;
+
+// A state on its own cache line
+typedef struct {
+    RANDOM__ALIGN(RANDOM_CACHE_LINE) Random__State state;
+} Random__StateAligned;
+
+// Fails to compile if the alignment didn't take effect, or if RANDOM_CACHE_LINE
+// isn't a power of two of at least 32, the size of the state
+typedef char random__check_state_aligned[sizeof(Random__StateAligned) == RANDOM_CACHE_LINE ? 1 : -1];
+
+// n states in structure-of-arrays layout, word i of state t is s[i * n + t].
+// With one state per GPU thread, neighboring threads then access neighboring
+// words, which coalesces the loads and stores.
+typedef struct {
+    uint64_t *s;
+    size_t n;
+} Random__StateSoA;
+
+// Holds the second standard normal value of the last polar method pair
+typedef struct {
+    double spare;
+    int has_spare;
+} Random__GaussianCache;
+
+// Counters for RANDOM_STATS, one set per thread. They are defined in the file
+// that defines RANDOM_IMPLEMENTATION.
+typedef struct {
+    uint64_t steps;                // Generator steps, counting every lane
+    uint64_t range_samples;        // Values from the range functions
+    uint64_t range_candidates;     // Outputs they tried, including rejected ones
+    uint64_t range_divisions;      // Divisions they did
+    uint64_t gaussian_samples;     // Values from the Gaussian functions
+    uint64_t gaussian_slow;        // Ziggurat values that took the slow path
+    uint64_t gaussian_candidates;  // Values they tried, including rejected ones
+} Random__Stats;
+
+// Device code can't reach the host's thread local counters, so it doesn't count
+#if defined(RANDOM_STATS) && !defined(__CUDA_ARCH__) && !defined(__HIP_DEVICE_COMPILE__)
+#if defined(__GNUC__)
+#define RANDOM__THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define RANDOM__THREAD_LOCAL __declspec(thread)
+#elif defined(__cplusplus) && __cplusplus >= 201103L
+#define RANDOM__THREAD_LOCAL thread_local
+#else
+#define RANDOM__THREAD_LOCAL _Thread_local
+#endif
+
+extern RANDOM__THREAD_LOCAL Random__Stats random__stats;
+#define RANDOM__STAT(name, n) ((void)(random__stats.name += (n)))
+#else
+#define RANDOM__STAT(name, n) ((void)0)
+#endif
 
 // SplitMix64 implementation based on the one by Sebastiano Vigna:
 //     https://prng.di.unimi.it/splitmix64.c
 // This is only used to seed the RNG.
-static inline uint64_t random__split_mix_64(uint64_t x) {
+RANDOM_HOST_DEVICE static inline uint64_t random__split_mix_64(uint64_t x) {
     x += 0x9e3779b97f4a7c15;
     x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
     x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
     return x ^ (x >> 31);
 }
 
-static inline void random_seed(RandomState *state, uint64_t seed) {
-    state->s[0] = (seed = random__split_mix_64(seed));
-    state->s[1] = (seed = random__split_mix_64(seed));
-    state->s[2] = (seed = random__split_mix_64(seed));
-    state->s[3] = (seed = random__split_mix_64(seed));
+RANDOM_HOST_DEVICE static inline void random__seed(uint64_t s[4], uint64_t seed) {
+    s[0] = (seed = random__split_mix_64(seed));
+    s[1] = (seed = random__split_mix_64(seed));
+    s[2] = (seed = random__split_mix_64(seed));
+    s[3] = (seed = random__split_mix_64(seed));
 }
 
-static inline uint64_t random__rotl(const uint64_t x, int k) {
+RANDOM_HOST_DEVICE static inline uint64_t random__rotl(const uint64_t x, int k) {
     return (x << k) | (x >> (64 - k));
 }
 
-// xoshiro256++ implementation based on the one by David Blackman and Sebastiano Vigna:
+// xoshiro256++ and xoshiro256+ implementation based on the ones by David Blackman
+// and Sebastiano Vigna:
 //     https://prng.di.unimi.it/xoshiro256plusplus.c
-static inline uint64_t random_u64(RandomState *state) {
-    const uint64_t result = random__rotl(state->s[0] + state->s[3], 23) + state->s[0];
-    const uint64_t t = state->s[1] << 17;
+//     https://prng.di.unimi.it/xoshiro256plus.c
+RANDOM_HOST_DEVICE static inline uint64_t random__next(uint64_t s[4], int scrambler) {
+    RANDOM__STAT(steps, 1);
+    const uint64_t result = scrambler == RANDOM__PLUS_PLUS
+        ? random__rotl(s[0] + s[3], 23) + s[0]
+        : s[0] + s[3];
+    const uint64_t t = s[1] << 17;
 
-    state->s[2] ^= state->s[0];
-    state->s[3] ^= state->s[1];
-    state->s[1] ^= state->s[2];
-    state->s[0] ^= state->s[3];
-    state->s[2] ^= t;
-    state->s[3] = random__rotl(state->s[3], 45);
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = random__rotl(s[3], 45);
 
     return result;
 }
 
-// Debiased modulo (Java's method) from
-//     https://www.pcg-random.org/posts/bounded-rands.html
+// Jump functions based on the ones by David Blackman and Sebastiano Vigna, see
+// the reference implementations above. They only depend on the state
+// transition, so they are the same for both scramblers. Each one is equivalent
+// to 2^128 or 2^192 calls to random__next.
+RANDOM_HOST_DEVICE static inline void random__jump_poly(uint64_t s[4], const uint64_t poly[4]) {
+    uint64_t s0 = 0;
+    uint64_t s1 = 0;
+    uint64_t s2 = 0;
+    uint64_t s3 = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (poly[i] & ((uint64_t)1 << b)) {
+                s0 ^= s[0];
+                s1 ^= s[1];
+                s2 ^= s[2];
+                s3 ^= s[3];
+            }
+            random__next(s, RANDOM__PLUS);
+        }
+    }
 
-// If you need a faster method, I suggest reading that page. I chose this one
-// because it doesn't rely on compiler-specific details of 128 bit integers or
-// bit manipulation intrinsics.
-static inline uint64_t random_range(RandomState *state, uint64_t range) {
-    uint64_t x, r;
-    do {
-        x = random_u64(state);
-        r = x % range;
-    } while (x - r > (-range));
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+}
 
-    return r;
+RANDOM_HOST_DEVICE static inline void random__jump(uint64_t s[4]) {
+    const uint64_t JUMP[4] = {
+        0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c
+    };
+    random__jump_poly(s, JUMP);
 }
 
-static inline int random_int(RandomState *state, int lower, int upper) {
-    return lower + (int)random_range(state, upper - lower + 1);
+RANDOM_HOST_DEVICE static inline void random__long_jump(uint64_t s[4]) {
+    const uint64_t LONG_JUMP[4] = {
+        0x76e15d3efefdcbbf, 0xc5004e441c522fb3, 0x77710069854ee241, 0x39109bb02acbe635
+    };
+    random__jump_poly(s, LONG_JUMP);
 }
 
-static inline float random_float_01(RandomState *state) {
-    return 0x1p-24f * (random_u64(state) >> 40);
+// Allocates size bytes aligned to RANDOM_CACHE_LINE. The pointer returned by
+// malloc is stored right before the aligned block.
+static inline void *random__aligned_alloc(size_t size) {
+    const size_t align = RANDOM_CACHE_LINE;
+    if (size > (size_t)-1 - align - sizeof(void *)) {
+        return NULL;
+    }
+
+    void *base = malloc(size + align - 1 + sizeof(void *));
+    if (!base) {
+        return NULL;
+    }
+
+    const uintptr_t p = ((uintptr_t)base + sizeof(void *) + align - 1) & ~(uintptr_t)(align - 1);
+    ((void **)p)[-1] = base;
+    return (void *)p;
 }
 
-static inline double random_double_01(RandomState *state) {
-    return 0x1p-53 * (random_u64(state) >> 11);
+static inline void random__aligned_free(void *p) {
+    if (p) {
+        free(((void **)p)[-1]);
+    }
 }
 
-static inline float random_float(RandomState *state, float lower, float upper) {
-    return lower + (upper - lower) * random_float_01(state);
+// State i starts i jumps after a state seeded with seed
+static inline Random__StateAligned *random__alloc_states(size_t n, uint64_t seed) {
+    if (n > (size_t)-1 / sizeof(Random__StateAligned)) {
+        return NULL;
+    }
+
+    Random__StateAligned *states = (Random__StateAligned *)random__aligned_alloc(n * sizeof(Random__StateAligned));
+    if (!states) {
+        return NULL;
+    }
+
+    uint64_t s[4];
+    random__seed(s, seed);
+    for (size_t i = 0; i < n; i++) {
+        for (int j = 0; j < 4; j++) {
+            states[i].state.s[j] = s[j];
+        }
+        random__jump(s);
+    }
+    return states;
 }
 
-static inline double random_double(RandomState *state, double lower, double upper) {
-    return lower + (upper - lower) * random_double_01(state);
+// Seeds the states like random__alloc_states, state t starts t jumps after a
+// state seeded with seed
+static inline void random__seed_soa(Random__StateSoA *soa, uint64_t seed) {
+    uint64_t s[4];
+    random__seed(s, seed);
+    for (size_t t = 0; t < soa->n; t++) {
+        for (int i = 0; i < 4; i++) {
+            soa->s[i * soa->n + t] = s[i];
+        }
+        random__jump(s);
+    }
 }
 
-static inline float random_float_gaussian(RandomState *state, float mu, float sigma) {
+RANDOM_HOST_DEVICE static inline void random__load_soa(const Random__StateSoA *soa, size_t t, uint64_t s[4]) {
+    for (int i = 0; i < 4; i++) {
+        s[i] = soa->s[i * soa->n + t];
+    }
+}
+
+RANDOM_HOST_DEVICE static inline void random__store_soa(Random__StateSoA *soa, size_t t, const uint64_t s[4]) {
+    for (int i = 0; i < 4; i++) {
+        soa->s[i * soa->n + t] = s[i];
+    }
+}
+
+// Checkpoint format: an 8 byte tag followed by 32 bytes per state, the four
+// state words in order, each in little endian byte order
+#define RANDOM_STATES_BYTES(n) (8 + 32 * (size_t)(n))
+#define RANDOM_STATE_BYTES RANDOM_STATES_BYTES(1)
+
+static const unsigned char random__state_tag[8] = {'x', 'o', '2', '5', '6', 0, 0, 1};
+
+// Written out so that compilers turn them into a single load or store on little
+// endian targets
+static inline void random__store_le64(unsigned char *out, uint64_t x) {
+    out[0] = (unsigned char)x;
+    out[1] = (unsigned char)(x >> 8);
+    out[2] = (unsigned char)(x >> 16);
+    out[3] = (unsigned char)(x >> 24);
+    out[4] = (unsigned char)(x >> 32);
+    out[5] = (unsigned char)(x >> 40);
+    out[6] = (unsigned char)(x >> 48);
+    out[7] = (unsigned char)(x >> 56);
+}
+
+static inline uint64_t random__load_le64(const unsigned char *in) {
+    return (uint64_t)in[0] | ((uint64_t)in[1] << 8) | ((uint64_t)in[2] << 16) | ((uint64_t)in[3] << 24) |
+           ((uint64_t)in[4] << 32) | ((uint64_t)in[5] << 40) | ((uint64_t)in[6] << 48) | ((uint64_t)in[7] << 56);
+}
+
+// Saves n states, where word j of state i is at base + i * stride + j * step,
+// in bytes. This covers arrays of states with any padding (step 8) as well as
+// multi-lane states (stride 8, step 8 * lanes).
+static inline void random__states_save(const void *base, size_t n, size_t stride, size_t step,
+                                       unsigned char *out) {
+    const unsigned char *p = (const unsigned char *)base;
+    memcpy(out, random__state_tag, 8);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            random__store_le64(out + 8 + 32 * i + 8 * j, *(const uint64_t *)(p + i * stride + j * step));
+        }
+    }
+}
+
+// Returns -1 without changing the states if the tag doesn't match or one of
+// the states is all zero, which xoshiro can't leave
+static inline int random__states_load(void *base, size_t n, size_t stride, size_t step, const unsigned char *in) {
+    unsigned char *p = (unsigned char *)base;
+    if (memcmp(in, random__state_tag, 8) != 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint64_t any = 0;
+        for (size_t j = 0; j < 4; j++) {
+            any |= random__load_le64(in + 8 + 32 * i + 8 * j);
+        }
+        if (any == 0) {
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            *(uint64_t *)(p + i * stride + j * step) = random__load_le64(in + 8 + 32 * i + 8 * j);
+        }
+    }
+    return 0;
+}
+
+// The value fits in 24 bits, so going through int32_t gives the compiler a
+// plain 32 bit int to float conversion, which vectorizes.
+RANDOM_HOST_DEVICE static inline float random__to_float_01(uint64_t x) {
+    return 0x1p-24f * (float)(int32_t)(x >> 40);
+}
+
+// Second float from the same output, for generating two floats at once. This
+// uses bits 16 to 39, which are independent of the ones used above and clear of
+// the weak low bits of xoshiro256+.
+RANDOM_HOST_DEVICE static inline float random__to_float_01_low(uint64_t x) {
+    return 0x1p-24f * (float)(int32_t)((x >> 16) & 0xffffff);
+}
+
+RANDOM_HOST_DEVICE static inline double random__to_double_01(uint64_t x) {
+    return 0x1p-53 * (x >> 11);
+}
+
+// Builds the float in [1, 2) from 23 or 52 random mantissa bits and subtracts
+// 1. This saves the int to float conversion, but gives one bit less precision.
+RANDOM_HOST_DEVICE static inline float random__to_float_01_fast(uint64_t x) {
+    const uint32_t bits = (uint32_t)(x >> 41) | 0x3f800000;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f - 1.0f;
+}
+
+RANDOM_HOST_DEVICE static inline double random__to_double_01_fast(uint64_t x) {
+    const uint64_t bits = (x >> 12) | 0x3ff0000000000000;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d - 1.0;
+}
+
+// Number of leading zero bits, x != 0
+static inline int random__clz64(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    while (!(x & ((uint64_t)1 << 63))) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// Returns e such that the result lies in [2^e, 2^(e + 1)), with probability
+// 2^e, by counting the leading zeros of as many outputs as needed. Stops at
+// min_e, which stands for the subnormal range [0, 2^(min_e + 1)) of the
+// caller's type.
+static inline int random__exponent_01(uint64_t s[4], int scrambler, int min_e) {
+    int e = -1;
+    for (;;) {
+        const uint64_t y = random__next(s, scrambler);
+        if (y != 0) {
+            e -= random__clz64(y);
+            return e < min_e ? min_e : e;
+        }
+        e -= 64;
+        if (e < min_e) {
+            return min_e;
+        }
+    }
+}
+
+// Full precision uniforms: every float or double in [0, 1) can be returned, with
+// a probability proportional to the gap to the next one. The mantissa comes
+// from one output and the exponent from at least one more.
+static inline float random__float_01_full(uint64_t s[4], int scrambler) {
+    const uint32_t mantissa = (uint32_t)(random__next(s, scrambler) >> 41);
+    const int e = random__exponent_01(s, scrambler, -127);
+
+    // A zero exponent field makes the mantissa a subnormal, uniform in
+    // [0, 2^-126)
+    const uint32_t bits = ((uint32_t)(e < -126 ? 0 : 127 + e) << 23) | mantissa;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline double random__double_01_full(uint64_t s[4], int scrambler) {
+    const uint64_t mantissa = random__next(s, scrambler) >> 12;
+    const int e = random__exponent_01(s, scrambler, -1023);
+    const uint64_t bits = ((uint64_t)(e < -1022 ? 0 : 1023 + e) << 52) | mantissa;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// Multi-lane states are stored as s[i][lane]. The lane functions take pointers
+// s0..s3 to the first lane's state words. Lane 0 is seeded like a scalar state
+// and every following lane starts one jump after the previous one.
+static inline void random__seed_lanes(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3,
+                                      int lanes, uint64_t seed) {
+    uint64_t s[4];
+    random__seed(s, seed);
+    for (int i = 0; i < lanes; i++) {
+        s0[i] = s[0];
+        s1[i] = s[1];
+        s2[i] = s[2];
+        s3[i] = s[3];
+        random__jump(s);
+    }
+}
+
+// Steps the given number of lanes
+static inline void random__next_lanes(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3,
+                                      uint64_t *out, int lanes, int scrambler) {
+    for (int i = 0; i < lanes; i++) {
+        const uint64_t result = scrambler == RANDOM__PLUS_PLUS
+            ? random__rotl(s0[i] + s3[i], 23) + s0[i]
+            : s0[i] + s3[i];
+        const uint64_t t = s1[i] << 17;
+
+        s2[i] ^= s0[i];
+        s3[i] ^= s1[i];
+        s1[i] ^= s2[i];
+        s0[i] ^= s3[i];
+        s2[i] ^= t;
+        s3[i] = random__rotl(s3[i], 45);
+
+        out[i] = result;
+    }
+}
+
+// The RANDOM_IMPLEMENTATION blocks of random.h and random_float.h pick the AVX2
+// or AVX-512 lane functions at run time. GCC and Clang can compile them for
+// those targets with function attributes, even when the rest of the file isn't.
+#if defined(RANDOM_IMPLEMENTATION) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RANDOM__DISPATCH
+#define RANDOM__TARGET_AVX2 __attribute__((target("avx2")))
+#define RANDOM__TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define RANDOM__TARGET_AVX2
+#define RANDOM__TARGET_AVX512
+#endif
+
+#if defined(__AVX2__) || defined(RANDOM__DISPATCH)
+RANDOM__TARGET_AVX2 static inline __m256i random__rotl_avx2(__m256i x, int k) {
+    return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+}
+
+// Same as random__next_lanes for 4 lanes
+RANDOM__TARGET_AVX2 static inline void random__next_lanes_avx2(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3,
+                                           uint64_t *out, int scrambler) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)s0);
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)s1);
+    __m256i v2 = _mm256_loadu_si256((const __m256i *)s2);
+    __m256i v3 = _mm256_loadu_si256((const __m256i *)s3);
+
+    const __m256i result = scrambler == RANDOM__PLUS_PLUS
+        ? _mm256_add_epi64(random__rotl_avx2(_mm256_add_epi64(v0, v3), 23), v0)
+        : _mm256_add_epi64(v0, v3);
+    const __m256i t = _mm256_slli_epi64(v1, 17);
+
+    v2 = _mm256_xor_si256(v2, v0);
+    v3 = _mm256_xor_si256(v3, v1);
+    v1 = _mm256_xor_si256(v1, v2);
+    v0 = _mm256_xor_si256(v0, v3);
+    v2 = _mm256_xor_si256(v2, t);
+    v3 = random__rotl_avx2(v3, 45);
+
+    _mm256_storeu_si256((__m256i *)s0, v0);
+    _mm256_storeu_si256((__m256i *)s1, v1);
+    _mm256_storeu_si256((__m256i *)s2, v2);
+    _mm256_storeu_si256((__m256i *)s3, v3);
+    _mm256_storeu_si256((__m256i *)out, result);
+}
+#endif
+
+#if defined(__AVX512F__) || defined(RANDOM__DISPATCH)
+// GCC 12 warns about the undefined vectors that avx512fintrin.h passes to its
+// masked builtins, wherever this gets inlined
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Same as random__next_lanes for 8 lanes
+RANDOM__TARGET_AVX512 static inline void random__next_lanes_avx512(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3,
+                                             uint64_t *out, int scrambler) {
+    __m512i v0 = _mm512_loadu_si512((const void *)s0);
+    __m512i v1 = _mm512_loadu_si512((const void *)s1);
+    __m512i v2 = _mm512_loadu_si512((const void *)s2);
+    __m512i v3 = _mm512_loadu_si512((const void *)s3);
+
+    const __m512i result = scrambler == RANDOM__PLUS_PLUS
+        ? _mm512_add_epi64(_mm512_rol_epi64(_mm512_add_epi64(v0, v3), 23), v0)
+        : _mm512_add_epi64(v0, v3);
+    const __m512i t = _mm512_slli_epi64(v1, 17);
+
+    v2 = _mm512_xor_si512(v2, v0);
+    v3 = _mm512_xor_si512(v3, v1);
+    v1 = _mm512_xor_si512(v1, v2);
+    v0 = _mm512_xor_si512(v0, v3);
+    v2 = _mm512_xor_si512(v2, t);
+    v3 = _mm512_rol_epi64(v3, 45);
+
+    _mm512_storeu_si512((void *)s0, v0);
+    _mm512_storeu_si512((void *)s1, v1);
+    _mm512_storeu_si512((void *)s2, v2);
+    _mm512_storeu_si512((void *)s3, v3);
+    _mm512_storeu_si512((void *)out, result);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+static inline void random__next_x4(uint64_t s[4][4], uint64_t out[4], int scrambler) {
+    RANDOM__STAT(steps, 4);
+#if defined(__AVX2__)
+    random__next_lanes_avx2(s[0], s[1], s[2], s[3], out, scrambler);
+#else
+    random__next_lanes(s[0], s[1], s[2], s[3], out, 4, scrambler);
+#endif
+}
+
+static inline void random__next_x8(uint64_t s[4][8], uint64_t out[8], int scrambler) {
+    RANDOM__STAT(steps, 8);
+#if defined(__AVX512F__)
+    random__next_lanes_avx512(s[0], s[1], s[2], s[3], out, scrambler);
+#elif defined(__AVX2__)
+    random__next_lanes_avx2(s[0], s[1], s[2], s[3], out, scrambler);
+    random__next_lanes_avx2(s[0] + 4, s[1] + 4, s[2] + 4, s[3] + 4, out + 4, scrambler);
+#else
+    random__next_lanes(s[0], s[1], s[2], s[3], out, 8, scrambler);
+#endif
+}
+
+// Number of values the Gaussian fill functions generate per block
+#define RANDOM__GAUSSIAN_BLOCK 256
+
+// Ziggurat method for sampling a normal distribution, based on the ZIGNOR
+// variant by Jurgen A. Doornik:
+//     https://www.doornik.com/research/ziggurat.pdf
+// The density is covered by 128 layers of equal area. X[i] is the right edge of
+// layer i, and R[i] = X[i + 1] / X[i] is the fraction of the layer that lies
+// entirely below the curve. Most samples are accepted after one table lookup,
+// a multiply and a compare, the rest fall back to the slow path.
+static const double random__zig_x[129] = {
+    3.7130862467425505, 3.4426198558990002, 3.2230849845811416, 3.0832288582168683,
+    2.9786962526477803, 2.8943440070215289, 2.8231253505489105, 2.7611693723871769,
+    2.7061135731218195, 2.6564064112613597, 2.6109722484318474, 2.5690336259249378,
+    2.5300096723888275, 2.4934545220953721, 2.4590181774118305, 2.4264206455337498,
+    2.3954342780110625, 2.3658713701176386, 2.3375752413392368, 2.310413683698763,
+    2.2842740596774718, 2.2590595738691985, 2.2346863955909795, 2.2110814088787034,
+    2.1881804320760492, 2.1659267937489219, 2.1442701823603953, 2.1231657086739766,
+    2.1025731351892385, 2.0824562379920168, 2.0627822745083084, 2.0435215366550676,
+    2.0246469733773855, 2.0061338699634721, 1.9879595741276199, 1.9701032608543265,
+    1.9525457295535567, 1.9352692282966228, 1.9182573008645099, 1.9014946531051511,
+    1.884967035707759, 1.8686611409944887, 1.8525645117280911, 1.836665460258446,
+    1.8209529965961255, 1.8054167642192285, 1.7900469825998586, 1.7748343955860695,
+    1.7597702248995934, 1.7448461281138004, 1.7300541605637305, 1.7153867407136676,
+    1.7008366185699169, 1.6863968467791681, 1.6720607540976009, 1.6578219209540241,
+    1.6436741568628686, 1.6296114794706347, 1.615628095043161, 1.6017183802213781,
+    1.5878768648905761, 1.5740982160230008, 1.5603772223661689, 1.5467087798599104,
+    1.5330878776740433, 1.5195095847659401, 1.5059690368632033, 1.492461423781354,
+    1.4789819769899242, 1.4655259573427108, 1.4520886428892246, 1.4386653166845635,
+    1.4252512545140601, 1.4118417124470577, 1.3984319141310053, 1.3850170377326518,
+    1.3715922024273426, 1.3581524543301435, 1.344692751753547, 1.3312079496656273,
+    1.3176927832094141, 1.3041418501286168, 1.2905495919261964, 1.2769102735601556,
+    1.2632179614546211, 1.2494664995730682, 1.2356494832633627, 1.2217602305399964,
+    1.2077917504159497, 1.1937367078331287, 1.1795873846639882, 1.1653356361647524,
+    1.1509728421488674, 1.1364898520131608, 1.1218769225825422, 1.107123647534036,
+    1.0922188769072774, 1.0771506248928957, 1.0619059636948243, 1.0464709007640454,
+    1.0308302360681956, 1.0149673952513305, 0.99886423349298359, 0.98250080351542901,
+    0.9658550794011499, 0.94890262551130644, 0.93161619661515083, 0.91396525102303228,
+    0.89591535258093769, 0.87742742911292337, 0.85845684319381321, 0.83895221429757738,
+    0.81885390670035729, 0.79809206064405691, 0.77658398789475991, 0.75423066445405562,
+    0.73091191064248884, 0.70647961133543646, 0.68074791866915463, 0.65347863873997525,
+    0.6243585973360507, 0.59296294247144832, 0.55869217840818519, 0.52065603876206057,
+    0.47743783729668982, 0.42654798635542351, 0.36287143109703196, 0.27232086481396467,
+    0.0
+};
+
+static const double random__zig_r[128] = {
+    0.92715860260966809, 0.93623028957388921, 0.95660799295292287, 0.96609638454488822,
+    0.97168148798278098, 0.97539385218210217, 0.97805411716851776, 0.98006069464048895,
+    0.98163153152396454, 0.98289638112718658, 0.98393754566633251, 0.98480987047335344,
+    0.98555137923289438, 0.98618930308197361, 0.98674367998678636, 0.98722959781119435,
+    0.98765864371032963, 0.98803987015701755, 0.98838045631210891, 0.98868617156930783,
+    0.98896170724285448, 0.98921091831302443, 0.98943700254369094, 0.98964263517811046,
+    0.98983007159696879, 0.99000122651835243, 0.99015773578346966, 0.99030100505080254,
+    0.99043224853369438, 0.99055252008432182, 0.99066273833585672, 0.99076370718921958,
+    0.99085613262097194, 0.99094063656071807, 0.99101776841657896, 0.99108801469971874,
+    0.99115180710216499, 0.99120952930818496, 0.99126152276245516, 0.99130809157396138,
+    0.99134950669991539, 0.99138600952667588, 0.9914178149430195, 0.99144511398384472,
+    0.99146807610853294, 0.99148685116701207, 0.99150157109748349, 0.9915123513923666,
+    0.99151929236293068, 0.99152248022806455, 0.99152198804846459, 0.99151787652404422,
+    0.99151019466943868, 0.99149898038000517, 0.99148426089860509, 0.9914660531916395,
+    0.99144436424122284, 0.99141919125900113, 0.99139052182587151, 0.99135833396074968,
+    0.99132259612049656, 0.99128326713214987, 0.9912402960576856, 0.991193621990624,
+    0.99114317378289896, 0.99108886969948096, 0.99103061699728945, 0.99096831142390407,
+    0.99090183663049125, 0.99083106349214667, 0.9907558493275227, 0.99067603700809548,
+    0.99059145394572945, 0.99050191094523621, 0.99040720090638834, 0.99030709735723799,
+    0.99020135279756305, 0.99008969682771364, 0.98997183403395694, 0.98984744159647786,
+    0.98971616658035255, 0.98957762286281981, 0.98943138764184679, 0.98927699746094222,
+    0.98911394367309524, 0.9889416672520418, 0.98875955284124373, 0.98856692190915973,
+    0.98836302485260341, 0.98814703185694575, 0.98791802228090508, 0.98767497228253098,
+    0.98741674033883642, 0.98714205023059953, 0.98684947096108866, 0.98653739294616549,
+    0.98620399964423899, 0.98584723357553894, 0.98546475539408995, 0.98505389429899071,
+    0.98461158757103473, 0.98413430634945731, 0.98361796385447464, 0.98305780101683371,
+    0.98244824275257281, 0.98178271570611264, 0.98105341485447561, 0.98025100142276667,
+    0.97936420732745055, 0.97837931059633121, 0.97727942988529215, 0.97604356093863154,
+    0.97464523783007639, 0.97305063687522453, 0.97121583268629852, 0.9690827290502092,
+    0.96657285378538182, 0.96357758631187951, 0.95994217656590097, 0.95543841882869618,
+    0.94971534788091627, 0.9422042060159378, 0.93191932674895062, 0.91699279707169312,
+    0.89341051972459762, 0.85071654937943442, 0.75046102138899429, 0.0
+};
+
+static const float random__zig_xf[129] = {
+    3.71308625f, 3.44261986f, 3.22308498f, 3.08322886f, 2.97869625f, 2.89434401f,
+    2.82312535f, 2.76116937f, 2.70611357f, 2.65640641f, 2.61097225f, 2.56903363f,
+    2.53000967f, 2.49345452f, 2.45901818f, 2.42642065f, 2.39543428f, 2.36587137f,
+    2.33757524f, 2.31041368f, 2.28427406f, 2.25905957f, 2.2346864f, 2.21108141f,
+    2.18818043f, 2.16592679f, 2.14427018f, 2.12316571f, 2.10257314f, 2.08245624f,
+    2.06278227f, 2.04352154f, 2.02464697f, 2.00613387f, 1.98795957f, 1.97010326f,
+    1.95254573f, 1.93526923f, 1.9182573f, 1.90149465f, 1.88496704f, 1.86866114f,
+    1.85256451f, 1.83666546f, 1.820953f, 1.80541676f, 1.79004698f, 1.7748344f,
+    1.75977022f, 1.74484613f, 1.73005416f, 1.71538674f, 1.70083662f, 1.68639685f,
+    1.67206075f, 1.65782192f, 1.64367416f, 1.62961148f, 1.6156281f, 1.60171838f,
+    1.58787686f, 1.57409822f, 1.56037722f, 1.54670878f, 1.53308788f, 1.51950958f,
+    1.50596904f, 1.49246142f, 1.47898198f, 1.46552596f, 1.45208864f, 1.43866532f,
+    1.42525125f, 1.41184171f, 1.39843191f, 1.38501704f, 1.3715922f, 1.35815245f,
+    1.34469275f, 1.33120795f, 1.31769278f, 1.30414185f, 1.29054959f, 1.27691027f,
+    1.26321796f, 1.2494665f, 1.23564948f, 1.22176023f, 1.20779175f, 1.19373671f,
+    1.17958738f, 1.16533564f, 1.15097284f, 1.13648985f, 1.12187692f, 1.10712365f,
+    1.09221888f, 1.07715062f, 1.06190596f, 1.0464709f, 1.03083024f, 1.0149674f,
+    0.998864233f, 0.982500804f, 0.965855079f, 0.948902626f, 0.931616197f, 0.913965251f,
+    0.895915353f, 0.877427429f, 0.858456843f, 0.838952214f, 0.818853907f, 0.798092061f,
+    0.776583988f, 0.754230664f, 0.730911911f, 0.706479611f, 0.680747919f, 0.653478639f,
+    0.624358597f, 0.592962942f, 0.558692178f, 0.520656039f, 0.477437837f, 0.426547986f,
+    0.362871431f, 0.272320865f, 0.0f
+};
+
+static const float random__zig_rf[128] = {
+    0.927158603f, 0.93623029f, 0.956607993f, 0.966096385f, 0.971681488f, 0.975393852f,
+    0.978054117f, 0.980060695f, 0.981631532f, 0.982896381f, 0.983937546f, 0.98480987f,
+    0.985551379f, 0.986189303f, 0.98674368f, 0.987229598f, 0.987658644f, 0.98803987f,
+    0.988380456f, 0.988686172f, 0.988961707f, 0.989210918f, 0.989437003f, 0.989642635f,
+    0.989830072f, 0.990001227f, 0.990157736f, 0.990301005f, 0.990432249f, 0.99055252f,
+    0.990662738f, 0.990763707f, 0.990856133f, 0.990940637f, 0.991017768f, 0.991088015f,
+    0.991151807f, 0.991209529f, 0.991261523f, 0.991308092f, 0.991349507f, 0.99138601f,
+    0.991417815f, 0.991445114f, 0.991468076f, 0.991486851f, 0.991501571f, 0.991512351f,
+    0.991519292f, 0.99152248f, 0.991521988f, 0.991517877f, 0.991510195f, 0.99149898f,
+    0.991484261f, 0.991466053f, 0.991444364f, 0.991419191f, 0.991390522f, 0.991358334f,
+    0.991322596f, 0.991283267f, 0.991240296f, 0.991193622f, 0.991143174f, 0.99108887f,
+    0.991030617f, 0.990968311f, 0.990901837f, 0.990831063f, 0.990755849f, 0.990676037f,
+    0.990591454f, 0.990501911f, 0.990407201f, 0.990307097f, 0.990201353f, 0.990089697f,
+    0.989971834f, 0.989847442f, 0.989716167f, 0.989577623f, 0.989431388f, 0.989276997f,
+    0.989113944f, 0.988941667f, 0.988759553f, 0.988566922f, 0.988363025f, 0.988147032f,
+    0.987918022f, 0.987674972f, 0.98741674f, 0.98714205f, 0.986849471f, 0.986537393f,
+    0.986204f, 0.985847234f, 0.985464755f, 0.985053894f, 0.984611588f, 0.984134306f,
+    0.983617964f, 0.983057801f, 0.982448243f, 0.981782716f, 0.981053415f, 0.980251001f,
+    0.979364207f, 0.978379311f, 0.97727943f, 0.976043561f, 0.974645238f, 0.973050637f,
+    0.971215833f, 0.969082729f, 0.966572854f, 0.963577586f, 0.959942177f, 0.955438419f,
+    0.949715348f, 0.942204206f, 0.931919327f, 0.916992797f, 0.89341052f, 0.850716549f,
+    0.750461021f, 0.0f
+};
+
+// Each sample uses one 64 bit output: the top 7 bits select the layer and the
+// next 54 (or 24 for floats) bits give a signed uniform -1 <= u < 1.
+static inline int random__zig_layer(uint64_t x) {
+    return (int)(x >> 57);
+}
+
+static inline double random__zig_u(uint64_t x) {
+    return 0x1p-53 * (double)(int64_t)((x >> 3) & 0x3fffffffffffff) - 1.0;
+}
+
+static inline float random__zig_uf(uint64_t x) {
+    return 0x1p-23f * (float)(int32_t)((x >> 33) & 0xffffff) - 1.0f;
+}
+
+// Slow path, for when u is outside of the rectangle in layer i
+static inline double random__double_normal_slow(uint64_t s[4], int scrambler, double u, int i) {
+    RANDOM__STAT(gaussian_slow, 1);
+    for (;;) {
+        if (i == 0) {
+            // Sample the tail beyond X[1] using Marsaglia's method
+            const double r = random__zig_x[1];
+            double x, y;
+            do {
+                RANDOM__STAT(gaussian_candidates, 1);
+                x = log(1.0 - random__to_double_01(random__next(s, scrambler))) / r;
+                y = log(1.0 - random__to_double_01(random__next(s, scrambler)));
+            } while (-2.0 * y < x * x);
+
+            return u < 0.0 ? x - r : r - x;
+        }
+
+        const double x = u * random__zig_x[i];
+        const double f0 = exp(-0.5 * (random__zig_x[i] * random__zig_x[i] - x * x));
+        const double f1 = exp(-0.5 * (random__zig_x[i + 1] * random__zig_x[i + 1] - x * x));
+        if (f1 + random__to_double_01(random__next(s, scrambler)) * (f0 - f1) < 1.0) {
+            return x;
+        }
+
+        const uint64_t bits = random__next(s, scrambler);
+        RANDOM__STAT(gaussian_candidates, 1);
+        i = random__zig_layer(bits);
+        u = random__zig_u(bits);
+        if (fabs(u) < random__zig_r[i]) {
+            return u * random__zig_x[i];
+        }
+    }
+}
+
+static inline float random__float_normal_slow(uint64_t s[4], int scrambler, float u, int i) {
+    RANDOM__STAT(gaussian_slow, 1);
+    for (;;) {
+        if (i == 0) {
+            const float r = random__zig_xf[1];
+            float x, y;
+            do {
+                RANDOM__STAT(gaussian_candidates, 1);
+                x = logf(1.0f - random__to_float_01(random__next(s, scrambler))) / r;
+                y = logf(1.0f - random__to_float_01(random__next(s, scrambler)));
+            } while (-2.0f * y < x * x);
+
+            return u < 0.0f ? x - r : r - x;
+        }
+
+        const float x = u * random__zig_xf[i];
+        const float f0 = expf(-0.5f * (random__zig_xf[i] * random__zig_xf[i] - x * x));
+        const float f1 = expf(-0.5f * (random__zig_xf[i + 1] * random__zig_xf[i + 1] - x * x));
+        if (f1 + random__to_float_01(random__next(s, scrambler)) * (f0 - f1) < 1.0f) {
+            return x;
+        }
+
+        const uint64_t bits = random__next(s, scrambler);
+        RANDOM__STAT(gaussian_candidates, 1);
+        i = random__zig_layer(bits);
+        u = random__zig_uf(bits);
+        if (fabsf(u) < random__zig_rf[i]) {
+            return u * random__zig_xf[i];
+        }
+    }
+}
+
+static inline float random__float_normal(uint64_t s[4], int scrambler) {
+    RANDOM__STAT(gaussian_samples, 1);
+    RANDOM__STAT(gaussian_candidates, 1);
+    const uint64_t bits = random__next(s, scrambler);
+    const int i = random__zig_layer(bits);
+    const float u = random__zig_uf(bits);
+    if (fabsf(u) < random__zig_rf[i]) {
+        return u * random__zig_xf[i];
+    }
+
+    return random__float_normal_slow(s, scrambler, u, i);
+}
+
+static inline double random__double_normal(uint64_t s[4], int scrambler) {
+    RANDOM__STAT(gaussian_samples, 1);
+    RANDOM__STAT(gaussian_candidates, 1);
+    const uint64_t bits = random__next(s, scrambler);
+    const int i = random__zig_layer(bits);
+    const double u = random__zig_u(bits);
+    if (fabs(u) < random__zig_r[i]) {
+        return u * random__zig_x[i];
+    }
+
+    return random__double_normal_slow(s, scrambler, u, i);
+}
+
+// The Gaussian fills take the fast path for a whole block without branching,
+// remembering which values need the slow path, and then run the slow path for
+// those.
+static inline void random__fill_float_gaussian(uint64_t state[4], int scrambler, float *out, size_t n,
+                                               float mu, float sigma) {
+    uint64_t s[4] = {state[0], state[1], state[2], state[3]};
+    uint64_t bits[RANDOM__GAUSSIAN_BLOCK];
+    size_t slow[RANDOM__GAUSSIAN_BLOCK];
+    for (size_t start = 0; start < n; start += RANDOM__GAUSSIAN_BLOCK) {
+        const size_t m = n - start < RANDOM__GAUSSIAN_BLOCK ? n - start : RANDOM__GAUSSIAN_BLOCK;
+        float *block = out + start;
+        RANDOM__STAT(gaussian_samples, m);
+        RANDOM__STAT(gaussian_candidates, m);
+        for (size_t j = 0; j < m; j++) {
+            bits[j] = random__next(s, scrambler);
+        }
+
+        size_t n_slow = 0;
+        for (size_t j = 0; j < m; j++) {
+            const int i = random__zig_layer(bits[j]);
+            const float u = random__zig_uf(bits[j]);
+            block[j] = mu + sigma * (u * random__zig_xf[i]);
+            slow[n_slow] = j;
+            n_slow += !(fabsf(u) < random__zig_rf[i]);
+        }
+
+        for (size_t k = 0; k < n_slow; k++) {
+            const size_t j = slow[k];
+            const float x = random__float_normal_slow(s, scrambler, random__zig_uf(bits[j]),
+                                                      random__zig_layer(bits[j]));
+            block[j] = mu + sigma * x;
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        state[i] = s[i];
+    }
+}
+
+static inline void random__fill_double_gaussian(uint64_t state[4], int scrambler, double *out, size_t n,
+                                                double mu, double sigma) {
+    uint64_t s[4] = {state[0], state[1], state[2], state[3]};
+    uint64_t bits[RANDOM__GAUSSIAN_BLOCK];
+    size_t slow[RANDOM__GAUSSIAN_BLOCK];
+    for (size_t start = 0; start < n; start += RANDOM__GAUSSIAN_BLOCK) {
+        const size_t m = n - start < RANDOM__GAUSSIAN_BLOCK ? n - start : RANDOM__GAUSSIAN_BLOCK;
+        double *block = out + start;
+        RANDOM__STAT(gaussian_samples, m);
+        RANDOM__STAT(gaussian_candidates, m);
+        for (size_t j = 0; j < m; j++) {
+            bits[j] = random__next(s, scrambler);
+        }
+
+        size_t n_slow = 0;
+        for (size_t j = 0; j < m; j++) {
+            const int i = random__zig_layer(bits[j]);
+            const double u = random__zig_u(bits[j]);
+            block[j] = mu + sigma * (u * random__zig_x[i]);
+            slow[n_slow] = j;
+            n_slow += !(fabs(u) < random__zig_r[i]);
+        }
+
+        for (size_t k = 0; k < n_slow; k++) {
+            const size_t j = slow[k];
+            const double x = random__double_normal_slow(s, scrambler, random__zig_u(bits[j]),
+                                                        random__zig_layer(bits[j]));
+            block[j] = mu + sigma * x;
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        state[i] = s[i];
+    }
+}
+
+static inline void random__float_gaussian_pair(uint64_t s[4], int scrambler, float mu, float sigma, float out[2]) {
     // See https://en.wikipedia.org/wiki/Marsaglia_polar_method
-    float u, s;
+    float u, v, r;
+    RANDOM__STAT(gaussian_samples, 2);
     do {
-        u = random_float_01(state) * 2.0 - 1.0;
-        s = u * u;
-    } while (s >= 1.0 || s == 0.0);
+        RANDOM__STAT(gaussian_candidates, 2);
+        u = random__to_float_01(random__next(s, scrambler)) * 2.0f - 1.0f;
+        v = random__to_float_01(random__next(s, scrambler)) * 2.0f - 1.0f;
+        r = u * u + v * v;
+    } while (r >= 1.0f || r == 0.0f);
 
-    return mu + sigma * (u * sqrt(-0.5 * log(s) / s));
+    const float m = sqrtf(-2.0f * logf(r) / r);
+    out[0] = mu + sigma * (u * m);
+    out[1] = mu + sigma * (v * m);
 }
 
-static inline double random_double_gaussian(RandomState *state, double mu, double sigma) {
+static inline void random__double_gaussian_pair(uint64_t s[4], int scrambler, double mu, double sigma, double out[2]) {
     // See https://en.wikipedia.org/wiki/Marsaglia_polar_method
-    double u, s;
+    double u, v, r;
+    RANDOM__STAT(gaussian_samples, 2);
     do {
-        u = random_double_01(state) * 2.0 - 1.0;
-        s = u * u;
-    } while (s >= 1.0 || s == 0.0);
+        RANDOM__STAT(gaussian_candidates, 2);
+        u = random__to_double_01(random__next(s, scrambler)) * 2.0 - 1.0;
+        v = random__to_double_01(random__next(s, scrambler)) * 2.0 - 1.0;
+        r = u * u + v * v;
+    } while (r >= 1.0 || r == 0.0);
 
-    return mu + sigma * (u * sqrt(-0.5 * log(s) / s));
+    const double m = sqrt(-2.0 * log(r) / r);
+    out[0] = mu + sigma * (u * m);
+    out[1] = mu + sigma * (v * m);
 }
 
-#ifdef __cplusplus
-}  //  extern "C"
+static inline float random__float_gaussian_cached(uint64_t s[4], int scrambler, Random__GaussianCache *cache,
+                                                  float mu, float sigma) {
+    if (cache->has_spare) {
+        cache->has_spare = 0;
+        return mu + sigma * (float)cache->spare;
+    }
+
+    float pair[2];
+    random__float_gaussian_pair(s, scrambler, 0.0f, 1.0f, pair);
+    cache->spare = pair[1];
+    cache->has_spare = 1;
+    return mu + sigma * pair[0];
+}
+
+static inline double random__double_gaussian_cached(uint64_t s[4], int scrambler, Random__GaussianCache *cache,
+                                                    double mu, double sigma) {
+    if (cache->has_spare) {
+        cache->has_spare = 0;
+        return mu + sigma * cache->spare;
+    }
+
+    double pair[2];
+    random__double_gaussian_pair(s, scrambler, 0.0, 1.0, pair);
+    cache->spare = pair[1];
+    cache->has_spare = 1;
+    return mu + sigma * pair[0];
+}
+
+#elif RANDOM__CORE_VERSION != 1
+#error "random.h and random_float.h are from incompatible versions"
+#endif  //  RANDOM__CORE_INCLUDE
+
+typedef Random__State RandomState;
+typedef Random__StateX4 RandomStateX4;
+typedef Random__StateX8 RandomStateX8;
+typedef Random__GaussianCache RandomGaussianCache;
+
+// A RandomState on its own cache line, for arrays of per-thread states. Pass
+// &aligned.state to the functions.
+typedef Random__StateAligned RandomStateAligned;
+
+// States in structure-of-arrays layout, see Random__StateSoA
+typedef Random__StateSoA RandomStateSoA;
+
+// Counters collected when RANDOM_STATS is defined
+typedef Random__Stats RandomStats;
+
+RANDOM_HOST_DEVICE static inline void random_seed(RandomState *state, uint64_t seed) {
+    random__seed(state->s, seed);
+}
+
+// Returns the high half of the 128 bit product a * b and stores the low half in
+// lo. RANDOM__HAS_MUL_128 is only defined where this maps to a native multiply.
+#if defined(__SIZEOF_INT128__)
+#define RANDOM__HAS_MUL_128
+static inline uint64_t random__mul_128(uint64_t a, uint64_t b, uint64_t *lo) {
+    __extension__ const unsigned __int128 m = (unsigned __int128)a * b;
+    *lo = (uint64_t)m;
+    return (uint64_t)(m >> 64);
+}
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define RANDOM__HAS_MUL_128
+static inline uint64_t random__mul_128(uint64_t a, uint64_t b, uint64_t *lo) {
+    uint64_t hi;
+    *lo = _umul128(a, b, &hi);
+    return hi;
+}
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+#define RANDOM__HAS_MUL_128
+static inline uint64_t random__mul_128(uint64_t a, uint64_t b, uint64_t *lo) {
+    *lo = a * b;
+    return __umulh(a, b);
+}
 #endif
 
-#endif  //  RANDOM_H_INCLUDE
+RANDOM_HOST_DEVICE static inline uint64_t random_u64(RandomState *state) {
+    return random__next(state->s, RANDOM__PLUS_PLUS);
+}
+
+RANDOM_HOST_DEVICE static inline void random_jump(RandomState *state) {
+    random__jump(state->s);
+}
+
+RANDOM_HOST_DEVICE static inline void random_long_jump(RandomState *state) {
+    random__long_jump(state->s);
+}
+
+static inline void random_seed_soa(RandomStateSoA *soa, uint64_t seed) {
+    random__seed_soa(soa, seed);
+}
+
+RANDOM_HOST_DEVICE static inline void random_load_soa(const RandomStateSoA *soa, size_t i, RandomState *state) {
+    random__load_soa(soa, i, state->s);
+}
+
+RANDOM_HOST_DEVICE static inline void random_store_soa(RandomStateSoA *soa, size_t i, const RandomState *state) {
+    random__store_soa(soa, i, state->s);
+}
+
+static inline RandomStateAligned *random_alloc_states(size_t n, uint64_t seed) {
+    return random__alloc_states(n, seed);
+}
+
+static inline void random_free_states(RandomStateAligned *states) {
+    random__aligned_free(states);
+}
+
+static inline void random_state_save(const RandomState *state, unsigned char out[RANDOM_STATE_BYTES]) {
+    random__states_save(state->s, 1, sizeof(state->s), sizeof(uint64_t), out);
+}
+
+static inline int random_state_load(RandomState *state, const unsigned char in[RANDOM_STATE_BYTES]) {
+    return random__states_load(state->s, 1, sizeof(state->s), sizeof(uint64_t), in);
+}
+
+// stride is the distance between states in bytes, e.g. sizeof(RandomStateAligned).
+// A smaller one would overlap the states, and one that isn't a multiple of 8
+// would misalign the words.
+static inline void random_states_save(const void *states, size_t n, size_t stride, unsigned char *out) {
+    assert(stride >= sizeof(RandomState) && stride % sizeof(uint64_t) == 0);
+    random__states_save(states, n, stride, sizeof(uint64_t), out);
+}
+
+static inline int random_states_load(void *states, size_t n, size_t stride, const unsigned char *in) {
+    assert(stride >= sizeof(RandomState) && stride % sizeof(uint64_t) == 0);
+    return random__states_load(states, n, stride, sizeof(uint64_t), in);
+}
+
+static inline void random_state_save_x4(const RandomStateX4 *state, unsigned char out[RANDOM_STATES_BYTES(4)]) {
+    random__states_save(state->s[0], 4, sizeof(uint64_t), sizeof(state->s[0]), out);
+}
+
+static inline int random_state_load_x4(RandomStateX4 *state, const unsigned char in[RANDOM_STATES_BYTES(4)]) {
+    return random__states_load(state->s[0], 4, sizeof(uint64_t), sizeof(state->s[0]), in);
+}
+
+static inline void random_state_save_x8(const RandomStateX8 *state, unsigned char out[RANDOM_STATES_BYTES(8)]) {
+    random__states_save(state->s[0], 8, sizeof(uint64_t), sizeof(state->s[0]), out);
+}
+
+static inline int random_state_load_x8(RandomStateX8 *state, const unsigned char in[RANDOM_STATES_BYTES(8)]) {
+    return random__states_load(state->s[0], 8, sizeof(uint64_t), sizeof(state->s[0]), in);
+}
+
+// Hashed fork in the style of Java's SplittableRandom: the child is seeded from
+// four outputs of the parent, each passed through SplitMix64. This puts the
+// child at an effectively random point of the period. Jumps work for a fixed
+// set of streams, but not for recursive splitting, where the child and the
+// parent would eventually jump onto each other's sequences.
+RANDOM_HOST_DEVICE static inline void random_split(RandomState *parent, RandomState *child) {
+    for (int i = 0; i < 4; i++) {
+        child->s[i] = random__split_mix_64(random_u64(parent));
+    }
+}
+
+static inline void random_fill_u64(RandomState *state, uint64_t *out, size_t n) {
+    RandomState s = *state;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random_u64(&s);
+    }
+    *state = s;
+}
+
+// Writes the tail of a byte fill from one more output, so that the bytes don't
+// depend on how dst is aligned
+static inline void random__store_bytes_tail(unsigned char *out, uint64_t x, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        out[i] = (unsigned char)(x >> (8 * i));
+    }
+}
+
+static inline void random_fill_bytes(RandomState *state, void *dst, size_t len) {
+    unsigned char *out = (unsigned char *)dst;
+    RandomState s = *state;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        random__store_le64(out + i, random_u64(&s));
+    }
+    if (i < len) {
+        random__store_bytes_tail(out + i, random_u64(&s), len - i);
+    }
+    *state = s;
+}
+
+// Bits are taken from the low end of an output. Refilling discards the bits
+// that are left, so the reservoir never has to combine two outputs.
+typedef struct {
+    uint64_t bits;
+    unsigned count;
+} RandomBits;
+
+static inline uint32_t random_bits(RandomState *state, RandomBits *reservoir, unsigned k) {
+    if (reservoir->count < k) {
+        reservoir->bits = random_u64(state);
+        reservoir->count = 64;
+    }
+
+    const uint32_t x = (uint32_t)(reservoir->bits & ((UINT64_C(1) << k) - 1));
+    reservoir->bits >>= k;
+    reservoir->count -= k;
+    return x;
+}
+
+// p as a 53 bit fixed point number, rounded up, so that comparing the top 53
+// bits of an output with it is exactly the same as random_double_01(state) < p
+static inline uint64_t random_bernoulli_threshold(double p) {
+    if (!(p > 0.0)) {
+        return 0;
+    }
+    if (p >= 1.0) {
+        return (uint64_t)1 << 53;
+    }
+
+    return (uint64_t)ceil(p * 9007199254740992.0);
+}
+
+static inline int random_bernoulli(RandomState *state, uint64_t threshold) {
+    return (random_u64(state) >> 11) < threshold;
+}
+
+// Compares 64 random 53 bit numbers with the threshold at once, one bit of each
+// per output, starting from the top. A lane is decided by the first bit where
+// it differs from the threshold, and once the threshold has no set bits left the
+// remaining lanes are equal or greater so far, so they all fail.
+static inline uint64_t random_bernoulli_mask(RandomState *state, uint64_t threshold) {
+    if (threshold >> 53) {
+        return ~(uint64_t)0;
+    }
+
+    uint64_t result = 0;
+    uint64_t undecided = ~(uint64_t)0;
+    uint64_t rest = threshold;
+    for (uint64_t bit = (uint64_t)1 << 52; rest && undecided; bit >>= 1) {
+        const uint64_t x = random_u64(state);
+        if (rest & bit) {
+            result |= undecided & ~x;
+            undecided &= x;
+            rest ^= bit;
+        } else {
+            undecided &= ~x;
+        }
+    }
+
+    return result;
+}
+
+// The rejection loop of random_range and random_buffer_range. next draws the
+// candidates from source. It's always a constant, so the compiler inlines it
+// and the loop is the same as calling the generator directly.
+static inline uint64_t random__range(uint64_t (*next)(void *source), void *source, uint64_t range) {
+    RANDOM__STAT(range_samples, 1);
+#if defined(RANDOM_FAST_RANGE) && defined(RANDOM__HAS_MUL_128)
+    uint64_t lo;
+    uint64_t hi = random__mul_128(next(source), range, &lo);
+    RANDOM__STAT(range_candidates, 1);
+    if (lo < range) {
+        const uint64_t threshold = -range % range;
+        RANDOM__STAT(range_divisions, 1);
+        while (lo < threshold) {
+            hi = random__mul_128(next(source), range, &lo);
+            RANDOM__STAT(range_candidates, 1);
+        }
+    }
+
+    return hi;
+#else
+    uint64_t x, r;
+    do {
+        x = next(source);
+        RANDOM__STAT(range_candidates, 1);
+        RANDOM__STAT(range_divisions, 1);
+        r = x % range;
+    } while (x - r > (-range));
+
+    return r;
+#endif
+}
+
+static inline uint64_t random__range_next(void *state) {
+    return random_u64((RandomState *)state);
+}
+
+// Debiased modulo (Java's method) from
+//     https://www.pcg-random.org/posts/bounded-rands.html
+
+// If you need a faster method, I suggest reading that page. I chose this one
+// because it doesn't rely on compiler-specific details of 128 bit integers or
+// bit manipulation intrinsics.
+
+// If RANDOM_FAST_RANGE is defined and a 64x64 -> 128 bit multiply is available,
+// Lemire's nearly divisionless method from the same page is used instead:
+//     https://arxiv.org/abs/1805.10941
+// It only divides in the rare case where the low half of the product falls
+// below range.
+static inline uint64_t random_range(RandomState *state, uint64_t range) {
+    return random__range(random__range_next, state, range);
+}
+
+// Same results as random_range, but with Lemire's method the threshold is
+// computed once up front instead of whenever the low half falls below range.
+static inline void random_fill_range(RandomState *state, uint64_t *out, size_t n, uint64_t range) {
+    RandomState s = *state;
+#if defined(RANDOM_FAST_RANGE) && defined(RANDOM__HAS_MUL_128)
+    const uint64_t threshold = -range % range;
+    RANDOM__STAT(range_samples, n);
+    RANDOM__STAT(range_divisions, 1);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t lo, hi;
+        do {
+            hi = random__mul_128(random_u64(&s), range, &lo);
+            RANDOM__STAT(range_candidates, 1);
+        } while (lo < threshold);
+        out[i] = hi;
+    }
+#else
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random_range(&s, range);
+    }
+#endif
+    *state = s;
+}
+
+// Lemire's method with a 32x32 -> 64 bit multiply, which is available
+// everywhere. x is the first candidate, further ones come from the high half of
+// new outputs.
+static inline uint32_t random__range_u32(RandomState *state, uint32_t x, uint32_t range) {
+    uint64_t m = (uint64_t)x * range;
+    RANDOM__STAT(range_samples, 1);
+    RANDOM__STAT(range_candidates, 1);
+    if ((uint32_t)m < range) {
+        const uint32_t threshold = (uint32_t)-range % range;
+        RANDOM__STAT(range_divisions, 1);
+        while ((uint32_t)m < threshold) {
+            m = (random_u64(state) >> 32) * range;
+            RANDOM__STAT(range_candidates, 1);
+        }
+    }
+
+    return (uint32_t)(m >> 32);
+}
+
+static inline uint32_t random_range_u32(RandomState *state, uint32_t range) {
+    return random__range_u32(state, (uint32_t)(random_u64(state) >> 32), range);
+}
+
+// Uses the high and then the low half of each output as a candidate, and only
+// advances when the candidate is accepted, so the loop doesn't branch on it
+static inline void random_fill_range_u32(RandomState *state, uint32_t *out, size_t n, uint32_t range) {
+    if (n == 0) {
+        return;
+    }
+
+    RandomState s = *state;
+    const uint32_t threshold = (uint32_t)-range % range;
+    RANDOM__STAT(range_samples, n);
+    RANDOM__STAT(range_divisions, 1);
+    size_t i = 0;
+    for (;;) {
+        const uint64_t x = random_u64(&s);
+        const uint64_t m0 = (x >> 32) * range;
+        out[i] = (uint32_t)(m0 >> 32);
+        i += (uint32_t)m0 >= threshold;
+        RANDOM__STAT(range_candidates, 1);
+        if (i == n) {
+            break;
+        }
+
+        const uint64_t m1 = (x & 0xffffffff) * range;
+        out[i] = (uint32_t)(m1 >> 32);
+        i += (uint32_t)m1 >= threshold;
+        RANDOM__STAT(range_candidates, 1);
+        if (i == n) {
+            break;
+        }
+    }
+    *state = s;
+}
+
+// The span is computed in 64 bits, since upper - lower overflows int when the
+// range covers more than half of it
+static inline int random_int(RandomState *state, int lower, int upper) {
+    const uint64_t range = (uint64_t)((int64_t)upper - lower) + 1;
+    return (int)((int64_t)lower + (int64_t)random_range(state, range));
+}
+
+#if defined(__GNUC__)
+#define RANDOM__PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER) && defined(_M_X64)
+#define RANDOM__PREFETCH(p) _mm_prefetch((const char *)(p), _MM_HINT_T0)
+#else
+#define RANDOM__PREFETCH(p) ((void)(p))
+#endif
+
+// Number of swaps the shuffle functions draw indices for at a time
+#define RANDOM__SHUFFLE_BATCH 32
+
+// Generates 0 <= x < range, with a 32 bit draw when range fits
+static inline size_t random__index(RandomState *state, size_t range) {
+    if ((uint64_t)range <= UINT32_MAX) {
+        return random_range_u32(state, (uint32_t)range);
+    }
+
+    return (size_t)random_range(state, range);
+}
+
+// Fisher-Yates, from the back: the element at i - 1 - k is swapped with
+// idx[k], which is drawn from 0 <= x < i - k, for 0 <= k < count. The indices
+// don't depend on the data, so a whole batch is drawn first, which lets the
+// caller prefetch the swap targets before touching them. While the ranges fit
+// in 32 bits, each output provides two indices.
+static inline void random__shuffle_batch(RandomState *state, size_t i, size_t count,
+                                         size_t idx[RANDOM__SHUFFLE_BATCH]) {
+    if ((uint64_t)i <= UINT32_MAX) {
+        for (size_t k = 0; k < count; k += 2) {
+            const uint64_t x = random_u64(state);
+            idx[k] = random__range_u32(state, (uint32_t)(x >> 32), (uint32_t)(i - k));
+            if (k + 1 < count) {
+                idx[k + 1] = random__range_u32(state, (uint32_t)x, (uint32_t)(i - k - 1));
+            }
+        }
+    } else {
+        for (size_t k = 0; k < count; k++) {
+            idx[k] = random__index(state, i - k);
+        }
+    }
+}
+
+static inline void random_shuffle(RandomState *state, void *base, size_t n, size_t elem_size) {
+    unsigned char *bytes = (unsigned char *)base;
+    unsigned char tmp[64];
+    size_t idx[RANDOM__SHUFFLE_BATCH];
+    RandomState s = *state;
+    for (size_t i = n; i > 1;) {
+        const size_t count = i - 1 < RANDOM__SHUFFLE_BATCH ? i - 1 : RANDOM__SHUFFLE_BATCH;
+        random__shuffle_batch(&s, i, count, idx);
+        for (size_t k = 0; k < count; k++) {
+            RANDOM__PREFETCH(bytes + idx[k] * elem_size);
+        }
+
+        for (size_t k = 0; k < count; k++) {
+            unsigned char *a = bytes + (i - 1 - k) * elem_size;
+            unsigned char *b = bytes + idx[k] * elem_size;
+            for (size_t left = elem_size; left > 0;) {
+                const size_t m = left < sizeof(tmp) ? left : sizeof(tmp);
+                memcpy(tmp, a, m);
+                memcpy(a, b, m);
+                memcpy(b, tmp, m);
+                a += m;
+                b += m;
+                left -= m;
+            }
+        }
+        i -= count;
+    }
+    *state = s;
+}
+
+static inline void random_shuffle_u32(RandomState *state, uint32_t *base, size_t n) {
+    size_t idx[RANDOM__SHUFFLE_BATCH];
+    RandomState s = *state;
+    for (size_t i = n; i > 1;) {
+        const size_t count = i - 1 < RANDOM__SHUFFLE_BATCH ? i - 1 : RANDOM__SHUFFLE_BATCH;
+        random__shuffle_batch(&s, i, count, idx);
+        for (size_t k = 0; k < count; k++) {
+            RANDOM__PREFETCH(base + idx[k]);
+        }
+
+        for (size_t k = 0; k < count; k++) {
+            const uint32_t tmp = base[i - 1 - k];
+            base[i - 1 - k] = base[idx[k]];
+            base[idx[k]] = tmp;
+        }
+        i -= count;
+    }
+    *state = s;
+}
+
+static inline void random_shuffle_u64(RandomState *state, uint64_t *base, size_t n) {
+    size_t idx[RANDOM__SHUFFLE_BATCH];
+    RandomState s = *state;
+    for (size_t i = n; i > 1;) {
+        const size_t count = i - 1 < RANDOM__SHUFFLE_BATCH ? i - 1 : RANDOM__SHUFFLE_BATCH;
+        random__shuffle_batch(&s, i, count, idx);
+        for (size_t k = 0; k < count; k++) {
+            RANDOM__PREFETCH(base + idx[k]);
+        }
+
+        for (size_t k = 0; k < count; k++) {
+            const uint64_t tmp = base[i - 1 - k];
+            base[i - 1 - k] = base[idx[k]];
+            base[idx[k]] = tmp;
+        }
+        i -= count;
+    }
+    *state = s;
+}
+
+static inline void random_shuffle_ptr(RandomState *state, void **base, size_t n) {
+    size_t idx[RANDOM__SHUFFLE_BATCH];
+    RandomState s = *state;
+    for (size_t i = n; i > 1;) {
+        const size_t count = i - 1 < RANDOM__SHUFFLE_BATCH ? i - 1 : RANDOM__SHUFFLE_BATCH;
+        random__shuffle_batch(&s, i, count, idx);
+        for (size_t k = 0; k < count; k++) {
+            RANDOM__PREFETCH(base + idx[k]);
+        }
+
+        for (size_t k = 0; k < count; k++) {
+            void *tmp = base[i - 1 - k];
+            base[i - 1 - k] = base[idx[k]];
+            base[idx[k]] = tmp;
+        }
+        i -= count;
+    }
+    *state = s;
+}
+
+// Floyd's algorithm, see
+//     https://fermatslibrary.com/s/a-sample-of-brilliance
+// Checking whether an index was already picked is a linear search through the
+// output, so this takes O(k^2) time, but no memory besides out.
+static inline void random_sample_indices(RandomState *state, size_t *out, size_t k, size_t n) {
+    size_t count = 0;
+    for (size_t j = n - k; j < n; j++) {
+        const size_t t = random__index(state, j + 1);
+        int found = 0;
+        for (size_t i = 0; i < count; i++) {
+            found |= out[i] == t;
+        }
+        out[count++] = found ? j : t;
+    }
+}
+
+// Algorithm R, see
+//     https://en.wikipedia.org/wiki/Reservoir_sampling
+static inline size_t random_reservoir_slot(RandomState *state, size_t i, size_t k) {
+    if (i < k) {
+        return i;
+    }
+
+    const size_t j = random__index(state, i + 1);
+    return j < k ? j : k;
+}
+
+// Entry i of an alias table: i is returned when the low half of the output is
+// below threshold, otherwise alias
+typedef struct {
+    uint32_t threshold;
+    uint32_t alias;
+} RandomAliasEntry;
+
+typedef struct {
+    RandomAliasEntry *entries;
+    uint32_t n;
+} RandomAliasTable;
+
+// Vose's alias method, see
+//     https://www.keithschwarz.com/darts-dice-coins/
+static inline int random_alias_init(RandomAliasTable *table, const double *weights, size_t n) {
+    table->entries = NULL;
+    table->n = 0;
+
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        if (!(weights[i] >= 0.0)) {
+            return -1;
+        }
+        sum += weights[i];
+    }
+    if (n == 0 || (uint64_t)n > UINT32_MAX || !(sum > 0.0 && sum < HUGE_VAL)) {
+        return -1;
+    }
+
+    RandomAliasEntry *entries = (RandomAliasEntry *)malloc(n * sizeof(RandomAliasEntry));
+    double *p = (double *)malloc(n * sizeof(double));
+    // Small probabilities are pushed from the front, large ones from the back
+    uint32_t *work = (uint32_t *)malloc(n * sizeof(uint32_t));
+    if (!entries || !p || !work) {
+        free(entries);
+        free(p);
+        free(work);
+        return -1;
+    }
+
+    size_t n_small = 0;
+    size_t n_large = 0;
+    for (size_t i = 0; i < n; i++) {
+        p[i] = weights[i] * ((double)n / sum);
+        if (p[i] < 1.0) {
+            work[n_small++] = (uint32_t)i;
+        } else {
+            work[n - 1 - n_large++] = (uint32_t)i;
+        }
+    }
+
+    while (n_small > 0 && n_large > 0) {
+        const uint32_t l = work[--n_small];
+        const uint32_t g = work[n - n_large--];
+        entries[l].threshold = (uint32_t)(p[l] * 4294967296.0);
+        entries[l].alias = g;
+
+        p[g] = (p[g] + p[l]) - 1.0;
+        if (p[g] < 1.0) {
+            work[n_small++] = g;
+        } else {
+            work[n - 1 - n_large++] = g;
+        }
+    }
+
+    // What's left has a probability of 1, up to rounding errors
+    while (n_small > 0) {
+        const uint32_t i = work[--n_small];
+        entries[i].threshold = UINT32_MAX;
+        entries[i].alias = i;
+    }
+    while (n_large > 0) {
+        const uint32_t i = work[n - n_large--];
+        entries[i].threshold = UINT32_MAX;
+        entries[i].alias = i;
+    }
+
+    free(p);
+    free(work);
+    table->entries = entries;
+    table->n = (uint32_t)n;
+    return 0;
+}
+
+static inline void random_alias_free(RandomAliasTable *table) {
+    free(table->entries);
+    table->entries = NULL;
+    table->n = 0;
+}
+
+// The high half of the output picks the entry and the low half is compared to
+// its threshold. A rejected index draws a new high half, which doesn't affect
+// the low half.
+static inline uint32_t random_alias_sample(RandomState *state, const RandomAliasTable *table) {
+    const uint64_t x = random_u64(state);
+    const uint32_t i = random__range_u32(state, (uint32_t)(x >> 32), table->n);
+    const RandomAliasEntry e = table->entries[i];
+    return (uint32_t)x < e.threshold ? i : e.alias;
+}
+
+// Number of outputs random_fill_alias generates per block
+#define RANDOM__ALIAS_BLOCK 256
+
+// Refills bits with as many outputs as the left samples need at least, so the
+// state never advances past where random_alias_sample would leave it
+static inline size_t random__alias_refill(RandomState *state, uint64_t *bits, size_t left) {
+    const size_t m = left < RANDOM__ALIAS_BLOCK ? left : RANDOM__ALIAS_BLOCK;
+    random_fill_u64(state, bits, m);
+    return m;
+}
+
+// Same results as random_alias_sample, but the outputs come in blocks from
+// random_fill_u64, and the threshold of the indices is computed once. A
+// rejected index takes the next output of the block.
+static inline void random_fill_alias(RandomState *state, const RandomAliasTable *table, uint32_t *out, size_t n) {
+    if (n == 0) {
+        return;
+    }
+    const uint32_t range = table->n;
+    const uint32_t threshold = (uint32_t)-range % range;
+    RANDOM__STAT(range_samples, n);
+    RANDOM__STAT(range_divisions, 1);
+
+    RandomState s = *state;
+    uint64_t bits[RANDOM__ALIAS_BLOCK];
+    size_t filled = 0;
+    size_t next = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (next == filled) {
+            filled = random__alias_refill(&s, bits, n - i);
+            next = 0;
+        }
+        const uint64_t x = bits[next++];
+        uint64_t m = (x >> 32) * range;
+        RANDOM__STAT(range_candidates, 1);
+        while ((uint32_t)m < threshold) {
+            // The current sample and the ones after it need at least n - i
+            // more outputs
+            if (next == filled) {
+                filled = random__alias_refill(&s, bits, n - i);
+                next = 0;
+            }
+            m = (bits[next++] >> 32) * range;
+            RANDOM__STAT(range_candidates, 1);
+        }
+
+        const uint32_t j = (uint32_t)(m >> 32);
+        const RandomAliasEntry e = table->entries[j];
+        out[i] = (uint32_t)x < e.threshold ? j : e.alias;
+    }
+    *state = s;
+}
+
+RANDOM_HOST_DEVICE static inline float random_float_01(RandomState *state) {
+    return random__to_float_01(random_u64(state));
+}
+
+// See random__to_float_01_fast and random__float_01_full
+RANDOM_HOST_DEVICE static inline float random_float_01_fast(RandomState *state) {
+    return random__to_float_01_fast(random_u64(state));
+}
+
+RANDOM_HOST_DEVICE static inline double random_double_01_fast(RandomState *state) {
+    return random__to_double_01_fast(random_u64(state));
+}
+
+static inline float random_float_01_full(RandomState *state) {
+    return random__float_01_full(state->s, RANDOM__PLUS_PLUS);
+}
+
+static inline double random_double_01_full(RandomState *state) {
+    return random__double_01_full(state->s, RANDOM__PLUS_PLUS);
+}
+
+RANDOM_HOST_DEVICE static inline void random_float2_01(RandomState *state, float out[2]) {
+    const uint64_t x = random_u64(state);
+    out[0] = random__to_float_01(x);
+    out[1] = random__to_float_01_low(x);
+}
+
+RANDOM_HOST_DEVICE static inline double random_double_01(RandomState *state) {
+    return random__to_double_01(random_u64(state));
+}
+
+static inline void random_fill_float_01(RandomState *state, float *out, size_t n) {
+    RandomState s = *state;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const uint64_t x = random_u64(&s);
+        out[i] = random__to_float_01(x);
+        out[i + 1] = random__to_float_01_low(x);
+    }
+    if (i < n) {
+        out[i] = random_float_01(&s);
+    }
+    *state = s;
+}
+
+static inline void random_fill_double_01(RandomState *state, double *out, size_t n) {
+    RandomState s = *state;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random_double_01(&s);
+    }
+    *state = s;
+}
+
+RANDOM_HOST_DEVICE static inline float random_float(RandomState *state, float lower, float upper) {
+    return lower + (upper - lower) * random_float_01(state);
+}
+
+RANDOM_HOST_DEVICE static inline double random_double(RandomState *state, double lower, double upper) {
+    return lower + (upper - lower) * random_double_01(state);
+}
+
+static inline void random_fill_float(RandomState *state, float *out, size_t n, float lower, float upper) {
+    RandomState s = *state;
+    const float scale = upper - lower;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const uint64_t x = random_u64(&s);
+        out[i] = lower + scale * random__to_float_01(x);
+        out[i + 1] = lower + scale * random__to_float_01_low(x);
+    }
+    if (i < n) {
+        out[i] = random_float(&s, lower, upper);
+    }
+    *state = s;
+}
+
+static inline void random_fill_double(RandomState *state, double *out, size_t n, double lower, double upper) {
+    RandomState s = *state;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random_double(&s, lower, upper);
+    }
+    *state = s;
+}
+
+// Pre-generated outputs of a RandomState, drawn one at a time
+#ifndef RANDOM_BUFFER_SIZE
+#define RANDOM_BUFFER_SIZE 256
+#endif
+
+typedef struct {
+    RANDOM__ALIGN(RANDOM_CACHE_LINE) uint64_t data[RANDOM_BUFFER_SIZE];
+    RandomState state;
+    size_t index;
+} RandomBuffer;
+
+static inline void random_buffer_init(RandomBuffer *buffer, uint64_t seed) {
+    random_seed(&buffer->state, seed);
+    buffer->index = RANDOM_BUFFER_SIZE;
+}
+
+static inline void random__buffer_refill(RandomBuffer *buffer) {
+    random_fill_u64(&buffer->state, buffer->data, RANDOM_BUFFER_SIZE);
+    buffer->index = 0;
+}
+
+static inline uint64_t random_buffer_u64(RandomBuffer *buffer) {
+    if (buffer->index == RANDOM_BUFFER_SIZE) {
+        random__buffer_refill(buffer);
+    }
+
+    return buffer->data[buffer->index++];
+}
+
+static inline uint64_t random__buffer_range_next(void *buffer) {
+    return random_buffer_u64((RandomBuffer *)buffer);
+}
+
+// Same method as random_range
+static inline uint64_t random_buffer_range(RandomBuffer *buffer, uint64_t range) {
+    return random__range(random__buffer_range_next, buffer, range);
+}
+
+static inline float random_buffer_float_01(RandomBuffer *buffer) {
+    return random__to_float_01(random_buffer_u64(buffer));
+}
+
+static inline double random_buffer_double_01(RandomBuffer *buffer) {
+    return random__to_double_01(random_buffer_u64(buffer));
+}
+
+static inline float random_float_gaussian(RandomState *state, float mu, float sigma) {
+    return mu + sigma * random__float_normal(state->s, RANDOM__PLUS_PLUS);
+}
+
+static inline double random_double_gaussian(RandomState *state, double mu, double sigma) {
+    return mu + sigma * random__double_normal(state->s, RANDOM__PLUS_PLUS);
+}
+
+static inline void random_fill_float_gaussian(RandomState *state, float *out, size_t n, float mu, float sigma) {
+    random__fill_float_gaussian(state->s, RANDOM__PLUS_PLUS, out, n, mu, sigma);
+}
+
+static inline void random_fill_double_gaussian(RandomState *state, double *out, size_t n, double mu, double sigma) {
+    random__fill_double_gaussian(state->s, RANDOM__PLUS_PLUS, out, n, mu, sigma);
+}
+
+static inline void random_float_gaussian_pair(RandomState *state, float mu, float sigma, float out[2]) {
+    random__float_gaussian_pair(state->s, RANDOM__PLUS_PLUS, mu, sigma, out);
+}
+
+static inline void random_double_gaussian_pair(RandomState *state, double mu, double sigma, double out[2]) {
+    random__double_gaussian_pair(state->s, RANDOM__PLUS_PLUS, mu, sigma, out);
+}
+
+static inline float random_float_gaussian_cached(RandomState *state, RandomGaussianCache *cache, float mu, float sigma) {
+    return random__float_gaussian_cached(state->s, RANDOM__PLUS_PLUS, cache, mu, sigma);
+}
+
+static inline double random_double_gaussian_cached(RandomState *state, RandomGaussianCache *cache, double mu, double sigma) {
+    return random__double_gaussian_cached(state->s, RANDOM__PLUS_PLUS, cache, mu, sigma);
+}
+
+// Ziggurat method for the exponential distribution, with the same layout as the
+// Gaussian tables above: 128 layers of equal area, where layer 0 covers the
+// tail beyond X[1]. The tail of an exponential distribution is another
+// exponential distribution, which makes it easy to sample.
+static const double random__zig_ex[129] = {
+    7.898315116615643, 6.898315116615642, 6.135192844501238, 5.665072466085739,
+    5.324182373137499, 5.05617414879851, 4.834984367324839, 4.646421132862482,
+    4.4819020722626846, 4.335840994085857, 4.204397939328747, 4.0848196168057544,
+    3.975064441378075, 3.873576497597234, 3.7791426637561014, 3.690798693076618,
+    3.6077654093724196, 3.5294041261239055, 3.4551847323964764, 3.3846623579615622,
+    3.3174599905696227, 3.2532553113859177, 3.1917705767376217, 3.1327647373866325,
+    3.0760272264889776, 3.0213730092917226, 2.9686385989038913, 2.917678820286674,
+    2.8683641598597425, 2.820578577915053, 2.7742176900678994, 2.729187245421314,
+    2.685401845136825, 2.642783857191138, 2.6012624923073595, 2.560773013129438,
+    2.5212560541977935, 2.4826570345737777, 2.4449256483378083, 2.408015420863445,
+    2.3718833209063668, 2.336489420262991, 2.301796594139413, 2.2677702564970694,
+    2.2343781255607675, 2.2015900154291232, 2.1693776503494964, 2.1377144987348085,
+    2.1065756244282947, 2.0759375530803346, 2.0457781518018145, 2.01607652051126,
+    1.9868128936065137, 1.9579685507727413, 1.9295257358924411, 1.9014675831544174,
+    1.8737780495709402, 1.8464418532086178, 1.8194444165212862, 1.792771814244565,
+    1.7664107253733166, 1.7403483887965308, 1.714572562210304, 1.6890714839696004,
+    1.6638338375742083, 1.6388487185144363, 1.6141056032282144, 1.5895943199438896,
+    1.565305021202523, 1.5412281578702771, 1.5173544544657909, 1.4936748856395368,
+    1.4701806536522053, 1.4468631667073302, 1.4237140179997592, 1.4007249653462668,
+    1.3778879112676259, 1.355194883392831, 1.3326380150558408, 1.3102095259531379,
+    1.28790170272645, 1.265706879329014, 1.2436174170255425, 1.2216256838653283,
+    1.199724033454319, 1.177904782835068, 1.1561601892626785, 1.134482425639467,
+    1.1128635543402394, 1.0912954991226862, 1.0697700147720637, 1.048278654074353,
+    1.026812731645221, 1.0053632840606228, 0.9839210256351699, 0.9624762990719218,
+    0.9410190200560892, 0.919538614677599, 0.8980239483334626, 0.8764632444670765,
+    0.8548439911302232, 0.8331528328807087, 0.8113754449219011, 0.7894963856054498,
+    0.7674989223936074, 0.7453648250265036, 0.7230741178398823, 0.7006047807539016,
+    0.6779323851462455, 0.6550296462513987, 0.6318658673168969, 0.6084062416121208,
+    0.5846109651383402, 0.5604340933044584, 0.535822045250431, 0.5107116137288664,
+    0.48502726569486937, 0.45867739948996483, 0.4315490220368338,
+    0.40349995151552276, 0.3743469874287274, 0.3438471885662803, 0.3116666672586584,
+    0.27732506927591033, 0.2400880527238203, 0.19873365552920025,
+    0.15095268593686975, 0.09133951810289996, 0.0
+};
+
+static const double random__zig_er[128] = {
+    0.8733907187500906, 0.8893755563186281, 0.923373170113658, 0.9398259960505365,
+    0.949662087893309, 0.9562535278722092, 0.9610002390624712, 0.9645923053689187,
+    0.9674109171012992, 0.9696845306512855, 0.971558752466213, 0.973130961529825,
+    0.974468855718561, 0.9756210226131562, 0.9766232771451718, 0.9775026246053581,
+    0.9782798285484573, 0.9789711262651752, 0.979589405517545, 0.9801450306457118,
+    0.9806464345112778, 0.9811005504446243, 0.9815131326226774, 0.9818889972105005,
+    0.9822322062930379, 0.9825462098768819, 0.9828339567382729, 0.9830979818326657,
+    0.9833404758665559, 0.9835633411491683, 0.9837682367869685, 0.9839566155242934,
+    0.9841297539797007, 0.9842887776195556, 0.9844346815065147, 0.9845683476321269,
+    0.9846905594694557, 0.9848020142490415, 0.9849033333592551, 0.9849950711926411,
+    0.9850777226976533, 0.9851517298461926, 0.9852174871884953, 0.9852753466359149,
+    0.9853256215872525, 0.9853685904941987, 0.9854044999451401, 0.9854335673332697,
+    0.9854559831640153, 0.9854719130477848, 0.9854814994165447, 0.9854848629965072,
+    0.9854821040639548, 0.9854733035068031, 0.9854585237107261, 0.9854378092854247,
+    0.9854111876438184, 0.9853786694444684, 0.9853402489053673, 0.9852959039952576,
+    0.98524559650685, 0.985189272014639, 0.985126859718419, 0.9850582721720698,
+    0.984983404895648, 0.9849021358672747, 0.9848143248897084, 0.9847198128248068,
+    0.9846184206872669, 0.9845099485870569, 0.9843941745077679, 0.9842708529056695,
+    0.9841397131114805, 0.9840004575137176, 0.9838527594988559, 0.9836962611193302,
+    0.9835305704555329, 0.9833552586322365, 0.9831698564431519, 0.9829738505293957,
+    0.9827666790482145, 0.9825477267570973, 0.9823163194249775, 0.9820717174660977,
+    0.9818131086726438, 0.9815395998986837, 0.9812502075192227, 0.9809438464531156,
+    0.98061931749545, 0.9802752926517819, 0.9799102981005783, 0.9795226943277913,
+    0.9791106528741317, 0.978672129005101, 0.9782048294481719, 0.9777061741296663,
+    0.9771732505712691, 0.9766027592526065, 0.9759909477844125, 0.9753335311282807,
+    0.9746255942902099, 0.9738614728302487, 0.973034605060599, 0.9721373477916901,
+    0.9711607446977594, 0.9700942324641779, 0.9689252643240699, 0.9676388225851685,
+    0.9662167800260697, 0.9646370525867594, 0.9628724593015395, 0.9608891644327495,
+    0.9586445118624132, 0.9560839564400719, 0.9531366211148917, 0.9497087057674927,
+    0.9456734330859634, 0.9408552122182237, 0.9350037444438537, 0.9277497705333086,
+    0.9185253257360486, 0.9064103986372458, 0.8898130548101018, 0.8657279103929729,
+    0.8277532066862522, 0.7595728339767294, 0.6050870677524696, 0.0
+};
+
+// The top 7 bits select the layer, the next 53 bits give 0 <= u < 1
+static inline double random__zig_eu(uint64_t x) {
+    return 0x1p-53 * (double)(int64_t)((x >> 4) & 0x1fffffffffffff);
+}
+
+static inline double random__exponential_slow(RandomState *state, double u, int i) {
+    for (;;) {
+        if (i == 0) {
+            return random__zig_ex[1] - log(1.0 - random_double_01(state));
+        }
+
+        const double x = u * random__zig_ex[i];
+        const double f0 = exp(x - random__zig_ex[i]);
+        const double f1 = exp(x - random__zig_ex[i + 1]);
+        if (f1 + random_double_01(state) * (f0 - f1) < 1.0) {
+            return x;
+        }
+
+        const uint64_t bits = random_u64(state);
+        i = random__zig_layer(bits);
+        u = random__zig_eu(bits);
+        if (u < random__zig_er[i]) {
+            return u * random__zig_ex[i];
+        }
+    }
+}
+
+static inline double random__exponential(RandomState *state) {
+    const uint64_t bits = random_u64(state);
+    const int i = random__zig_layer(bits);
+    const double u = random__zig_eu(bits);
+    if (u < random__zig_er[i]) {
+        return u * random__zig_ex[i];
+    }
+
+    return random__exponential_slow(state, u, i);
+}
+
+static inline double random_double_exponential(RandomState *state, double lambda) {
+    return random__exponential(state) / lambda;
+}
+
+static inline void random_fill_double_exponential(RandomState *state, double *out, size_t n, double lambda) {
+    RandomState s = *state;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random__exponential(&s) / lambda;
+    }
+    *state = s;
+}
+
+// Poisson distribution. Small means use inversion by sequential search, which
+// takes O(lambda) time. Larger ones use the PTRS method by Wolfgang Hormann:
+//     https://epub.wu.ac.at/1242/
+// The constants only depend on lambda, so the fill function computes them once.
+typedef struct {
+    double lambda;
+    double exp_neg_lambda;
+    double log_lambda;
+    double a;
+    double b;
+    double log_inv_alpha;
+    double v_r;
+} Random__PoissonSetup;
+
+static inline void random__poisson_setup(Random__PoissonSetup *setup, double lambda) {
+    setup->lambda = lambda;
+    if (lambda < 10.0) {
+        setup->exp_neg_lambda = exp(-lambda);
+        return;
+    }
+
+    const double b = 0.931 + 2.53 * sqrt(lambda);
+    setup->log_lambda = log(lambda);
+    setup->b = b;
+    setup->a = -0.059 + 0.02483 * b;
+    setup->log_inv_alpha = log(1.1239 + 1.1328 / (b - 3.4));
+    setup->v_r = 0.9277 - 3.6224 / (b - 2.0);
+}
+
+static inline uint64_t random__poisson(RandomState *state, const Random__PoissonSetup *setup) {
+    if (!(setup->lambda > 0.0)) {
+        return 0;
+    }
+
+    if (setup->lambda < 10.0) {
+        double u = random_double_01(state);
+        double p = setup->exp_neg_lambda;
+        uint64_t k = 0;
+        // The cutoff only matters when rounding keeps the sum below u
+        while (u > p && k < 1000) {
+            u -= p;
+            k++;
+            p *= setup->lambda / (double)k;
+        }
+        return k;
+    }
+
+    for (;;) {
+        const double u = random_double_01(state) - 0.5;
+        const double v = random_double_01(state);
+        const double us = 0.5 - fabs(u);
+        const double k = floor((2.0 * setup->a / us + setup->b) * u + setup->lambda + 0.43);
+        if (us >= 0.07 && v <= setup->v_r) {
+            return (uint64_t)k;
+        }
+        if (k < 0.0 || (us < 0.013 && v > us)) {
+            continue;
+        }
+        if (log(v) + setup->log_inv_alpha - log(setup->a / (us * us) + setup->b) <=
+            -setup->lambda + k * setup->log_lambda - lgamma(k + 1.0)) {
+            return (uint64_t)k;
+        }
+    }
+}
+
+static inline uint64_t random_poisson(RandomState *state, double lambda) {
+    Random__PoissonSetup setup;
+    random__poisson_setup(&setup, lambda);
+    return random__poisson(state, &setup);
+}
+
+static inline void random_fill_poisson(RandomState *state, uint64_t *out, size_t n, double lambda) {
+    Random__PoissonSetup setup;
+    random__poisson_setup(&setup, lambda);
+    RandomState s = *state;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random__poisson(&s, &setup);
+    }
+    *state = s;
+}
+
+// Binomial distribution. For p > 0.5 this samples the number of failures
+// instead. If n * p is small, inversion by sequential search is used, otherwise
+// the BTRS method by Wolfgang Hormann:
+//     https://epub.wu.ac.at/1242/
+// BTRS has a similar speed to BTPE for large n * p, but needs far fewer cases
+// and constants.
+typedef struct {
+    uint64_t n;
+    int flipped;
+    double p;
+    double q_n;
+    double r;
+    double g;
+    double bound;
+    double a;
+    double b;
+    double c;
+    double v_r;
+    double alpha;
+    double log_pq;
+    double m;
+    double h;
+} Random__BinomialSetup;
+
+static inline void random__binomial_setup(Random__BinomialSetup *setup, uint64_t n, double p) {
+    setup->n = n;
+    setup->flipped = p > 0.5;
+    p = setup->flipped ? 1.0 - p : p;
+    setup->p = p;
+    if (!(p > 0.0) || n == 0) {
+        return;
+    }
+
+    const double q = 1.0 - p;
+    const double np = (double)n * p;
+    if (np < 10.0) {
+        setup->q_n = exp((double)n * log1p(-p));
+        setup->r = p / q;
+        setup->g = setup->r * ((double)n + 1.0);
+        setup->bound = fmin((double)n, np + 10.0 * sqrt(np * q + 1.0));
+        return;
+    }
+
+    const double spq = sqrt(np * q);
+    setup->b = 1.15 + 2.53 * spq;
+    setup->a = -0.0873 + 0.0248 * setup->b + 0.01 * p;
+    setup->c = np + 0.5;
+    setup->v_r = 0.92 - 4.2 / setup->b;
+    setup->alpha = (2.83 + 5.1 / setup->b) * spq;
+    setup->log_pq = log(p / q);
+    setup->m = floor(((double)n + 1.0) * p);
+    setup->h = lgamma(setup->m + 1.0) + lgamma((double)n - setup->m + 1.0);
+}
+
+static inline uint64_t random__binomial_unflipped(RandomState *state, const Random__BinomialSetup *setup) {
+    if (!(setup->p > 0.0) || setup->n == 0) {
+        return 0;
+    }
+
+    const double n = (double)setup->n;
+    if (n * setup->p < 10.0) {
+        for (;;) {
+            double u = random_double_01(state);
+            double f = setup->q_n;
+            double k = 0.0;
+            while (u > f && k <= setup->bound) {
+                u -= f;
+                k += 1.0;
+                f *= setup->g / k - setup->r;
+            }
+            if (k <= setup->bound) {
+                return (uint64_t)k;
+            }
+        }
+    }
+
+    for (;;) {
+        const double u = random_double_01(state) - 0.5;
+        double v = random_double_01(state);
+        const double us = 0.5 - fabs(u);
+        const double k = floor((2.0 * setup->a / us + setup->b) * u + setup->c);
+        if (k < 0.0 || k > n) {
+            continue;
+        }
+        if (us >= 0.07 && v <= setup->v_r) {
+            return (uint64_t)k;
+        }
+
+        v = log(v * setup->alpha / (setup->a / (us * us) + setup->b));
+        if (v <= setup->h - lgamma(k + 1.0) - lgamma(n - k + 1.0) + (k - setup->m) * setup->log_pq) {
+            return (uint64_t)k;
+        }
+    }
+}
+
+static inline uint64_t random__binomial(RandomState *state, const Random__BinomialSetup *setup) {
+    const uint64_t k = random__binomial_unflipped(state, setup);
+    return setup->flipped ? setup->n - k : k;
+}
+
+static inline uint64_t random_binomial(RandomState *state, uint64_t n, double p) {
+    Random__BinomialSetup setup;
+    random__binomial_setup(&setup, n, p);
+    return random__binomial(state, &setup);
+}
+
+static inline void random_fill_binomial(RandomState *state, uint64_t *out, size_t count, uint64_t n, double p) {
+    Random__BinomialSetup setup;
+    random__binomial_setup(&setup, n, p);
+    RandomState s = *state;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = random__binomial(&s, &setup);
+    }
+    *state = s;
+}
+
+// Philox4x32-10 counter-based generator from "Parallel random numbers: as easy
+// as 1, 2, 3" by John K. Salmon et al.:
+//     https://www.thesalmons.org/john/random123/papers/random123sc11.pdf
+// Each block maps a 128 bit counter and a 64 bit key to 128 random bits.
+static inline void random__philox4x32(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4]) {
+    uint32_t x0 = counter[0];
+    uint32_t x1 = counter[1];
+    uint32_t x2 = counter[2];
+    uint32_t x3 = counter[3];
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+    for (int round = 0; round < 10; round++) {
+        const uint64_t m0 = (uint64_t)0xd2511f53 * x0;
+        const uint64_t m1 = (uint64_t)0xcd9e8d57 * x2;
+        x0 = (uint32_t)(m1 >> 32) ^ x1 ^ k0;
+        x1 = (uint32_t)m1;
+        x2 = (uint32_t)(m0 >> 32) ^ x3 ^ k1;
+        x3 = (uint32_t)m0;
+        k0 += 0x9e3779b9;
+        k1 += 0xbb67ae85;
+    }
+
+    out[0] = x0;
+    out[1] = x1;
+    out[2] = x2;
+    out[3] = x3;
+}
+
+// Block counter / 2 of the stream with the given key, as two 64 bit values
+static inline void random__philox_block(uint64_t key, uint64_t block, uint64_t out[2]) {
+    const uint32_t counter[4] = {(uint32_t)block, (uint32_t)(block >> 32), 0, 0};
+    const uint32_t k[2] = {(uint32_t)key, (uint32_t)(key >> 32)};
+    uint32_t x[4];
+    random__philox4x32(counter, k, x);
+    out[0] = x[0] | ((uint64_t)x[1] << 32);
+    out[1] = x[2] | ((uint64_t)x[3] << 32);
+}
+
+static inline uint64_t random_at(uint64_t key, uint64_t counter) {
+    uint64_t x[2];
+    random__philox_block(key, counter >> 1, x);
+    return x[counter & 1];
+}
+
+static inline void random_fill_at(uint64_t key, uint64_t counter, uint64_t *out, size_t n) {
+    uint64_t x[2];
+    size_t i = 0;
+    if (n > 0 && (counter & 1)) {
+        out[i++] = random_at(key, counter);
+    }
+    for (; i + 2 <= n; i += 2) {
+        random__philox_block(key, (counter + i) >> 1, x);
+        out[i] = x[0];
+        out[i + 1] = x[1];
+    }
+    if (i < n) {
+        out[i] = random_at(key, counter + i);
+    }
+}
+
+static inline void random_seed_x4(RandomStateX4 *state, uint64_t seed) {
+    random__seed_lanes(state->s[0], state->s[1], state->s[2], state->s[3], 4, seed);
+}
+
+static inline void random_seed_x8(RandomStateX8 *state, uint64_t seed) {
+    random__seed_lanes(state->s[0], state->s[1], state->s[2], state->s[3], 8, seed);
+}
+
+static inline void random_u64_x4(RandomStateX4 *state, uint64_t out[4]) {
+    random__next_x4(state->s, out, RANDOM__PLUS_PLUS);
+}
+
+static inline void random_u64_x8(RandomStateX8 *state, uint64_t out[8]) {
+    random__next_x8(state->s, out, RANDOM__PLUS_PLUS);
+}
+
+static inline void random_fill_u64_x4(RandomStateX4 *state, uint64_t *out, size_t n) {
+    RandomStateX4 s = *state;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        random_u64_x4(&s, out + i);
+    }
+    if (i < n) {
+        uint64_t tail[4];
+        random_u64_x4(&s, tail);
+        for (size_t j = 0; j < n - i; j++) {
+            out[i + j] = tail[j];
+        }
+    }
+    *state = s;
+}
+
+static inline void random_fill_u64_x8(RandomStateX8 *state, uint64_t *out, size_t n) {
+    RandomStateX8 s = *state;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        random_u64_x8(&s, out + i);
+    }
+    if (i < n) {
+        uint64_t tail[8];
+        random_u64_x8(&s, tail);
+        for (size_t j = 0; j < n - i; j++) {
+            out[i + j] = tail[j];
+        }
+    }
+    *state = s;
+}
+
+// The bytes of each step are stored lane by lane, in the same order as
+// random_fill_u64_x4 and random_fill_u64_x8 write the outputs
+static inline void random_fill_bytes_x4(RandomStateX4 *state, void *dst, size_t len) {
+    unsigned char *out = (unsigned char *)dst;
+    RandomStateX4 s = *state;
+    uint64_t x[4];
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        random_u64_x4(&s, x);
+        for (int j = 0; j < 4; j++) {
+            random__store_le64(out + i + 8 * j, x[j]);
+        }
+    }
+    if (i < len) {
+        random_u64_x4(&s, x);
+        for (int j = 0; i < len; i += 8, j++) {
+            random__store_bytes_tail(out + i, x[j], len - i < 8 ? len - i : 8);
+        }
+    }
+    *state = s;
+}
+
+static inline void random_fill_bytes_x8(RandomStateX8 *state, void *dst, size_t len) {
+    unsigned char *out = (unsigned char *)dst;
+    RandomStateX8 s = *state;
+    uint64_t x[8];
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        random_u64_x8(&s, x);
+        for (int j = 0; j < 8; j++) {
+            random__store_le64(out + i + 8 * j, x[j]);
+        }
+    }
+    if (i < len) {
+        random_u64_x8(&s, x);
+        for (int j = 0; i < len; i += 8, j++) {
+            random__store_bytes_tail(out + i, x[j], len - i < 8 ? len - i : 8);
+        }
+    }
+    *state = s;
+}
+
+// Defined in the file that defines RANDOM_IMPLEMENTATION
+void random_fill_u64_x4_dispatch(RandomStateX4 *state, uint64_t *out, size_t n);
+void random_fill_u64_x8_dispatch(RandomStateX8 *state, uint64_t *out, size_t n);
+void random_fill_bytes_x4_dispatch(RandomStateX4 *state, void *dst, size_t len);
+void random_fill_bytes_x8_dispatch(RandomStateX8 *state, void *dst, size_t len);
+const char *random_dispatch_target(void);
+
+#ifdef RANDOM_STATS
+void random_stats_get(RandomStats *stats);
+void random_stats_reset(void);
+void random_stats_dump(FILE *file, const RandomStats *stats);
+#endif
+
+#ifdef __cplusplus
+}  //  extern "C"
+#endif
+
+#endif  //  RANDOM_H_INCLUDE
+
+// Implementation shared by random.h and random_float.h, compiled once in the
+// file that defines RANDOM_IMPLEMENTATION, whichever of the headers it includes
+#if defined(RANDOM_IMPLEMENTATION) && !defined(RANDOM__SHARED_IMPLEMENTATION)
+#define RANDOM__SHARED_IMPLEMENTATION
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef RANDOM__DISPATCH
+// Each kernel writes steps steps of every lane to out, in the same order as the
+// fill functions, with the outputs in native byte order. x86 is little endian,
+// so that is also the byte order of random_fill_bytes_x4 and _x8. The headers
+// wrap them for their own scrambler.
+typedef void (*Random__KernelX4)(Random__StateX4 *state, void *out, size_t steps);
+typedef void (*Random__KernelX8)(Random__StateX8 *state, void *out, size_t steps);
+
+static inline void random__kernel_x4_generic(Random__StateX4 *state, void *out, size_t steps, int scrambler) {
+    Random__StateX4 s = *state;
+    uint64_t x[4];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes(s.s[0], s.s[1], s.s[2], s.s[3], x, 4, scrambler);
+        memcpy((unsigned char *)out + 32 * i, x, 32);
+    }
+    *state = s;
+}
+
+static inline void random__kernel_x8_generic(Random__StateX8 *state, void *out, size_t steps, int scrambler) {
+    Random__StateX8 s = *state;
+    uint64_t x[8];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes(s.s[0], s.s[1], s.s[2], s.s[3], x, 8, scrambler);
+        memcpy((unsigned char *)out + 64 * i, x, 64);
+    }
+    *state = s;
+}
+
+RANDOM__TARGET_AVX2 static inline void random__kernel_x4_avx2(Random__StateX4 *state, void *out, size_t steps,
+                                                              int scrambler) {
+    Random__StateX4 s = *state;
+    uint64_t x[4];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes_avx2(s.s[0], s.s[1], s.s[2], s.s[3], x, scrambler);
+        memcpy((unsigned char *)out + 32 * i, x, 32);
+    }
+    *state = s;
+}
+
+RANDOM__TARGET_AVX2 static inline void random__kernel_x8_avx2(Random__StateX8 *state, void *out, size_t steps,
+                                                              int scrambler) {
+    Random__StateX8 s = *state;
+    uint64_t x[8];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes_avx2(s.s[0], s.s[1], s.s[2], s.s[3], x, scrambler);
+        random__next_lanes_avx2(s.s[0] + 4, s.s[1] + 4, s.s[2] + 4, s.s[3] + 4, x + 4, scrambler);
+        memcpy((unsigned char *)out + 64 * i, x, 64);
+    }
+    *state = s;
+}
+
+RANDOM__TARGET_AVX512 static inline void random__kernel_x8_avx512(Random__StateX8 *state, void *out, size_t steps,
+                                                                  int scrambler) {
+    Random__StateX8 s = *state;
+    uint64_t x[8];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes_avx512(s.s[0], s.s[1], s.s[2], s.s[3], x, scrambler);
+        memcpy((unsigned char *)out + 64 * i, x, 64);
+    }
+    *state = s;
+}
+
+// 2 with AVX-512F, 1 with only AVX2, 0 otherwise. Indexes random__cpu_names.
+static int random__cpu_level(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") ? 2 : __builtin_cpu_supports("avx2") ? 1 : 0;
+}
+
+static const char *const random__cpu_names[3] = {"generic", "avx2", "avx512f"};
+#endif  //  RANDOM__DISPATCH
+
+#ifdef RANDOM_STATS
+RANDOM__THREAD_LOCAL Random__Stats random__stats;
+
+static double random__stats_ratio(uint64_t a, uint64_t b) {
+    return b ? (double)a / (double)b : 0.0;
+}
+
+// Prints the counters of the calling thread if stats is NULL
+static void random__stats_dump(FILE *file, const Random__Stats *stats) {
+    const Random__Stats s = stats ? *stats : random__stats;
+    fprintf(file, "steps: %llu\n", (unsigned long long)s.steps);
+    fprintf(file, "range: %llu samples, %.4f candidates and %.4f divisions per sample\n",
+            (unsigned long long)s.range_samples, random__stats_ratio(s.range_candidates, s.range_samples),
+            random__stats_ratio(s.range_divisions, s.range_samples));
+    fprintf(file, "gaussian: %llu samples, %.4f%% slow, %.4f candidates per sample\n",
+            (unsigned long long)s.gaussian_samples, 100.0 * random__stats_ratio(s.gaussian_slow, s.gaussian_samples),
+            random__stats_ratio(s.gaussian_candidates, s.gaussian_samples));
+}
+#endif  //  RANDOM_STATS
+
+#ifdef __cplusplus
+}  //  extern "C"
+#endif
+
+#endif  //  RANDOM__SHARED_IMPLEMENTATION
+
+#if defined(RANDOM_IMPLEMENTATION) && !defined(RANDOM_IMPLEMENTATION_INCLUDE)
+#define RANDOM_IMPLEMENTATION_INCLUDE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef RANDOM__DISPATCH
+static void random__fill_x4_generic(RandomStateX4 *state, void *out, size_t steps) {
+    random__kernel_x4_generic(state, out, steps, RANDOM__PLUS_PLUS);
+}
+
+static void random__fill_x8_generic(RandomStateX8 *state, void *out, size_t steps) {
+    random__kernel_x8_generic(state, out, steps, RANDOM__PLUS_PLUS);
+}
+
+RANDOM__TARGET_AVX2 static void random__fill_x4_avx2(RandomStateX4 *state, void *out, size_t steps) {
+    random__kernel_x4_avx2(state, out, steps, RANDOM__PLUS_PLUS);
+}
+
+RANDOM__TARGET_AVX2 static void random__fill_x8_avx2(RandomStateX8 *state, void *out, size_t steps) {
+    random__kernel_x8_avx2(state, out, steps, RANDOM__PLUS_PLUS);
+}
+
+RANDOM__TARGET_AVX512 static void random__fill_x8_avx512(RandomStateX8 *state, void *out, size_t steps) {
+    random__kernel_x8_avx512(state, out, steps, RANDOM__PLUS_PLUS);
+}
+
+// The generic kernels are the initial values, so calls from other constructors
+// that run before random__dispatch_init still work, just without the vector
+// instructions.
+static Random__KernelX4 random__fill_x4 = random__fill_x4_generic;
+static Random__KernelX8 random__fill_x8 = random__fill_x8_generic;
+static int random__dispatch_level;
+
+__attribute__((constructor)) static void random__dispatch_init(void) {
+    random__dispatch_level = random__cpu_level();
+    if (random__dispatch_level >= 1) {
+        random__fill_x4 = random__fill_x4_avx2;
+        random__fill_x8 = random__fill_x8_avx2;
+    }
+    if (random__dispatch_level >= 2) {
+        random__fill_x8 = random__fill_x8_avx512;
+    }
+}
+#endif  //  RANDOM__DISPATCH
+
+// The remainder that doesn't fill a whole step goes through the inline
+// functions, which continue the same sequence
+void random_fill_u64_x4_dispatch(RandomStateX4 *state, uint64_t *out, size_t n) {
+#ifdef RANDOM__DISPATCH
+    const size_t steps = n / 4;
+    RANDOM__STAT(steps, 4 * steps);
+    random__fill_x4(state, out, steps);
+    random_fill_u64_x4(state, out + 4 * steps, n - 4 * steps);
+#else
+    random_fill_u64_x4(state, out, n);
+#endif
+}
+
+void random_fill_u64_x8_dispatch(RandomStateX8 *state, uint64_t *out, size_t n) {
+#ifdef RANDOM__DISPATCH
+    const size_t steps = n / 8;
+    RANDOM__STAT(steps, 8 * steps);
+    random__fill_x8(state, out, steps);
+    random_fill_u64_x8(state, out + 8 * steps, n - 8 * steps);
+#else
+    random_fill_u64_x8(state, out, n);
+#endif
+}
+
+void random_fill_bytes_x4_dispatch(RandomStateX4 *state, void *dst, size_t len) {
+#ifdef RANDOM__DISPATCH
+    const size_t steps = len / 32;
+    RANDOM__STAT(steps, 4 * steps);
+    random__fill_x4(state, dst, steps);
+    random_fill_bytes_x4(state, (unsigned char *)dst + 32 * steps, len - 32 * steps);
+#else
+    random_fill_bytes_x4(state, dst, len);
+#endif
+}
+
+void random_fill_bytes_x8_dispatch(RandomStateX8 *state, void *dst, size_t len) {
+#ifdef RANDOM__DISPATCH
+    const size_t steps = len / 64;
+    RANDOM__STAT(steps, 8 * steps);
+    random__fill_x8(state, dst, steps);
+    random_fill_bytes_x8(state, (unsigned char *)dst + 64 * steps, len - 64 * steps);
+#else
+    random_fill_bytes_x8(state, dst, len);
+#endif
+}
+
+// Names the instruction set used by the functions above, e.g. for logging
+const char *random_dispatch_target(void) {
+#ifdef RANDOM__DISPATCH
+    return random__cpu_names[random__dispatch_level];
+#elif defined(__AVX512F__)
+    return "avx512f";
+#elif defined(__AVX2__)
+    return "avx2";
+#else
+    return "generic";
+#endif
+}
+
+#ifdef RANDOM_STATS
+void random_stats_get(RandomStats *stats) {
+    *stats = random__stats;
+}
+
+void random_stats_reset(void) {
+    memset(&random__stats, 0, sizeof(random__stats));
+}
+
+void random_stats_dump(FILE *file, const RandomStats *stats) {
+    random__stats_dump(file, stats);
+}
+#endif  //  RANDOM_STATS
+
+#ifdef __cplusplus
+}  //  extern "C"
+#endif
+
+#endif  //  RANDOM_IMPLEMENTATION
 
 /*
 To the extent possible under law, the author has dedicated all copyright and
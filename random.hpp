@@ -0,0 +1,332 @@
+/* random.hpp, C++ wrappers for random.h and random_float.h.
+
+Version: 1.1
+Author: Erik Fast (fasterik.net)
+License: CC0
+
+This header wraps the PRNGs from random.h and random_float.h in a class
+template that satisfies the standard UniformRandomBitGenerator requirements, so
+they can be passed directly to std::shuffle, std::sample and the distributions
+in <random>. Seeding, generation and make_table are constexpr, so fixed random
+tables can be computed at compile time. It requires C++17, or C++14 with
+support for hexadecimal floating point literals, which the C headers use (e.g.
+-std=gnu++14 on GCC and Clang).
+
+Constant expressions can't call the C functions, so random.hpp has its own
+copies of the generators, the seeding and the conversions, which are only used
+while the compiler evaluates a constant expression. At run time the engine
+calls the C functions. Telling the two apart needs std::is_constant_evaluated
+or __builtin_is_constant_evaluated (GCC 9, Clang 9, MSVC 19.25 and later), and
+other compilers use the copies at run time as well, with the same results.
+
+The namespace is rnd rather than random, because a namespace with that name
+would clash with the POSIX random() function from <stdlib.h>.
+
+
+API:
+
+// Algorithm tags
+rnd::xoshiro256pp  // random_u64 from random.h, state type RandomState
+rnd::xoshiro256p   // rf__next from random_float.h, state type RFState
+
+// Same as random_float_01 / random_double_01 on a 64 bit output
+constexpr float rnd::to_float_01(uint64_t x);
+constexpr double rnd::to_double_01(uint64_t x);
+
+template <class Algo>
+class rnd::engine {
+    typedef uint64_t result_type;
+    typedef typename Algo::state_type state_type;
+
+    static constexpr result_type min();
+    static constexpr result_type max();
+
+    // Seeds the same way as random_seed and rf_seed
+    constexpr explicit engine(uint64_t seed = 0);
+    constexpr void seed(uint64_t seed);
+
+    // Same as random_u64 or rf__next
+    constexpr result_type operator()();
+
+    // Same as random_float_01 / random_double_01 or rf_float_01 / rf_double_01
+    constexpr float float_01();
+    constexpr double double_01();
+
+    // Same as random_jump / random_long_jump or rf_jump / rf_long_jump
+    void jump();
+    void long_jump();
+
+    // The wrapped state, for use with the C functions
+    state_type *state();
+    const state_type *state() const;
+};
+
+// Fixed size array returned by make_table
+template <class T, size_t N>
+struct rnd::table {
+    T data[N];
+
+    constexpr size_t size() const;
+    constexpr const T &operator[](size_t i) const;
+    constexpr const T *begin() const;
+    constexpr const T *end() const;
+};
+
+// Generate N values of type uint64_t, float or double (0 <= x < 1) from an
+// engine with the given seed. Called in a constexpr context, the table is
+// computed by the compiler.
+template <size_t N, class T = uint64_t, class Algo = rnd::xoshiro256pp>
+constexpr rnd::table<T, N> rnd::make_table(uint64_t seed);
+
+
+Example:
+
+    rnd::engine<rnd::xoshiro256pp> gen(1234);
+    std::shuffle(v.begin(), v.end(), gen);
+    double x = random_double_01(gen.state());
+
+    constexpr auto salts = rnd::make_table<64>(1234);
+    constexpr auto dither = rnd::make_table<256, float>(5678);
+
+xoshiro256+ has weak low bits, so std::uniform_int_distribution and the other
+integer distributions should use rnd::xoshiro256pp. rnd::xoshiro256p is meant
+for the floating point distributions, in the same way as random_float.h.
+
+
+Changelog:
+
+1.1:
+  - Made generation constexpr, added to_float_01, to_double_01 and make_table.
+1.0:
+  - Initial release.
+
+*/
+
+#ifndef RANDOM_HPP_INCLUDE
+#define RANDOM_HPP_INCLUDE
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <type_traits>
+
+#include "random.h"
+#include "random_float.h"
+
+#if !defined(__cpp_lib_is_constant_evaluated) && defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define RANDOM_HPP__HAS_CONSTANT_EVALUATED
+#endif
+#endif
+#if !defined(__cpp_lib_is_constant_evaluated) && !defined(RANDOM_HPP__HAS_CONSTANT_EVALUATED) && \
+    ((defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925))
+#define RANDOM_HPP__HAS_CONSTANT_EVALUATED
+#endif
+
+namespace rnd {
+
+namespace detail {
+
+// True while a constant expression is evaluated, where only the C++ copies
+// below can be used. Where that can't be told, it's always true, so the copies
+// are used at run time too.
+constexpr bool constant_evaluated() {
+#if defined(__cpp_lib_is_constant_evaluated)
+    return std::is_constant_evaluated();
+#elif defined(RANDOM_HPP__HAS_CONSTANT_EVALUATED)
+    return __builtin_is_constant_evaluated();
+#else
+    return true;
+#endif
+}
+
+// Same as random__split_mix_64, but usable in constant expressions
+constexpr uint64_t split_mix_64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+template <class State>
+constexpr void seed(State *state, uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        state->s[i] = (seed = split_mix_64(seed));
+    }
+}
+
+constexpr uint64_t rotl(const uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// The state transition shared by xoshiro256++ and xoshiro256+
+template <class State>
+constexpr void step(State *state) {
+    const uint64_t t = state->s[1] << 17;
+
+    state->s[2] ^= state->s[0];
+    state->s[3] ^= state->s[1];
+    state->s[1] ^= state->s[2];
+    state->s[0] ^= state->s[3];
+    state->s[2] ^= t;
+    state->s[3] = rotl(state->s[3], 45);
+}
+
+}  //  namespace detail
+
+// Same as random_float_01 and random_double_01 on a 64 bit output
+constexpr float to_float_01(uint64_t x) {
+    return detail::constant_evaluated() ? 0x1p-24f * (float)(int32_t)(x >> 40) : random__to_float_01(x);
+}
+
+constexpr double to_double_01(uint64_t x) {
+    return detail::constant_evaluated() ? 0x1p-53 * (x >> 11) : random__to_double_01(x);
+}
+
+// The algorithms call the C functions, except in constant expressions, where
+// the C++ copies in detail give the same values
+struct xoshiro256pp {
+    typedef RandomState state_type;
+
+    static constexpr void seed(RandomState *state, uint64_t seed) {
+        if (!detail::constant_evaluated()) {
+            random_seed(state, seed);
+            return;
+        }
+        detail::seed(state, seed);
+    }
+
+    static constexpr uint64_t next(RandomState *state) {
+        if (!detail::constant_evaluated()) {
+            return random_u64(state);
+        }
+        const uint64_t result = detail::rotl(state->s[0] + state->s[3], 23) + state->s[0];
+        detail::step(state);
+        return result;
+    }
+
+    static constexpr float float_01(RandomState *state) {
+        return detail::constant_evaluated() ? to_float_01(next(state)) : random_float_01(state);
+    }
+
+    static constexpr double double_01(RandomState *state) {
+        return detail::constant_evaluated() ? to_double_01(next(state)) : random_double_01(state);
+    }
+
+    static void jump(RandomState *state) { random_jump(state); }
+    static void long_jump(RandomState *state) { random_long_jump(state); }
+};
+
+struct xoshiro256p {
+    typedef RFState state_type;
+
+    static constexpr void seed(RFState *state, uint64_t seed) {
+        if (!detail::constant_evaluated()) {
+            rf_seed(state, seed);
+            return;
+        }
+        detail::seed(state, seed);
+    }
+
+    static constexpr uint64_t next(RFState *state) {
+        if (!detail::constant_evaluated()) {
+            return rf__next(state);
+        }
+        const uint64_t result = state->s[0] + state->s[3];
+        detail::step(state);
+        return result;
+    }
+
+    static constexpr float float_01(RFState *state) {
+        return detail::constant_evaluated() ? to_float_01(next(state)) : rf_float_01(state);
+    }
+
+    static constexpr double double_01(RFState *state) {
+        return detail::constant_evaluated() ? to_double_01(next(state)) : rf_double_01(state);
+    }
+
+    static void jump(RFState *state) { rf_jump(state); }
+    static void long_jump(RFState *state) { rf_long_jump(state); }
+};
+
+template <class Algo>
+class engine {
+public:
+    typedef uint64_t result_type;
+    typedef typename Algo::state_type state_type;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT64_MAX; }
+
+    constexpr explicit engine(uint64_t seed = 0) : state_{} { Algo::seed(&state_, seed); }
+
+    constexpr void seed(uint64_t seed) { Algo::seed(&state_, seed); }
+
+    constexpr result_type operator()() { return Algo::next(&state_); }
+
+    constexpr float float_01() { return Algo::float_01(&state_); }
+    constexpr double double_01() { return Algo::double_01(&state_); }
+
+    void jump() { Algo::jump(&state_); }
+    void long_jump() { Algo::long_jump(&state_); }
+
+    state_type *state() { return &state_; }
+    const state_type *state() const { return &state_; }
+
+private:
+    state_type state_;
+};
+
+template <class T, size_t N>
+struct table {
+    T data[N];
+
+    constexpr size_t size() const { return N; }
+    constexpr const T &operator[](size_t i) const { return data[i]; }
+    constexpr const T *begin() const { return data; }
+    constexpr const T *end() const { return data + N; }
+};
+
+namespace detail {
+
+template <class T>
+struct convert;
+
+template <>
+struct convert<uint64_t> {
+    static constexpr uint64_t from(uint64_t x) { return x; }
+};
+
+template <>
+struct convert<float> {
+    static constexpr float from(uint64_t x) { return to_float_01(x); }
+};
+
+template <>
+struct convert<double> {
+    static constexpr double from(uint64_t x) { return to_double_01(x); }
+};
+
+}  //  namespace detail
+
+template <size_t N, class T = uint64_t, class Algo = xoshiro256pp>
+constexpr table<T, N> make_table(uint64_t seed) {
+    table<T, N> result{};
+    engine<Algo> gen(seed);
+    for (size_t i = 0; i < N; i++) {
+        result.data[i] = detail::convert<T>::from(gen());
+    }
+    return result;
+}
+
+}  //  namespace rnd
+
+#endif  //  RANDOM_HPP_INCLUDE
+
+/*
+To the extent possible under law, the author has dedicated all copyright and
+related and neighboring rights to this software to the public domain worldwide.
+This software is distributed without any warranty.
+
+See <http://creativecommons.org/publicdomain/zero/1.0/>.
+*/
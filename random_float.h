@@ -1,6 +1,6 @@
 /* random_float.h, a C header for fast and easy floating point number generation.
 
-Version: 1.0
+Version: 1.1
 Author: Erik Fast (fasterik.net)
 License: CC0
 
@@ -18,21 +18,206 @@ API:
 // Initialize the PRNG with a 64 bit seed
 void rf_seed(RFState *state, uint64_t seed);
 
+// Advance the state by 2^128 or 2^192 steps, for generating non-overlapping
+// sequences, e.g. one per thread
+void rf_jump(RFState *state);
+void rf_long_jump(RFState *state);
+
+// Allocate an array of n states on separate cache lines, where state i starts i
+// jumps after a state seeded with seed. Returns NULL if the allocation fails.
+RFStateAligned *rf_alloc_states(size_t n, uint64_t seed);
+void rf_free_states(RFStateAligned *states);
+
+// States in structure-of-arrays layout for GPUs, see below
+void rf_seed_soa(RFStateSoA *soa, uint64_t seed);
+void rf_load_soa(const RFStateSoA *soa, size_t i, RFState *state);
+void rf_store_soa(RFStateSoA *soa, size_t i, const RFState *state);
+
+// Save and restore states in a portable format of RANDOM_STATES_BYTES(n)
+// bytes. The load functions return 0 on success and -1 if the data isn't a
+// valid checkpoint. states points to n states that are stride bytes apart,
+// where stride is a multiple of 8 and at least sizeof(RFState).
+void rf_state_save(const RFState *state, unsigned char out[RANDOM_STATE_BYTES]);
+int rf_state_load(RFState *state, const unsigned char in[RANDOM_STATE_BYTES]);
+void rf_states_save(const void *states, size_t n, size_t stride, unsigned char *out);
+int rf_states_load(void *states, size_t n, size_t stride, const unsigned char *in);
+void rf_state_save_x4(const RFStateX4 *state, unsigned char out[RANDOM_STATES_BYTES(4)]);
+int rf_state_load_x4(RFStateX4 *state, const unsigned char in[RANDOM_STATES_BYTES(4)]);
+void rf_state_save_x8(const RFStateX8 *state, unsigned char out[RANDOM_STATES_BYTES(8)]);
+int rf_state_load_x8(RFStateX8 *state, const unsigned char in[RANDOM_STATES_BYTES(8)]);
+
 // Generate 0 <= x < 1
 float rf_float_01(RFState *state);
 double rf_double_01(RFState *state);
+void rf_fill_float_01(RFState *state, float *out, size_t n);
+void rf_fill_double_01(RFState *state, double *out, size_t n);
+
+// Generate two floats 0 <= x < 1 from a single 64 bit output
+void rf_float2_01(RFState *state, float out[2]);
+
+// Variants of rf_float_01 and rf_double_01: _fast builds the value from
+// random mantissa bits, which can be faster but has one bit less precision.
+// _full can return every float or double in the range, including tiny ones.
+float rf_float_01_fast(RFState *state);
+double rf_double_01_fast(RFState *state);
+float rf_float_01_full(RFState *state);
+double rf_double_01_full(RFState *state);
 
 // Generate lower <= x < upper
 float rf_float(RFState *state, float lower, float upper);
 double rf_double(RFState *state, double lower, double upper);
+void rf_fill_float(RFState *state, float *out, size_t n, float lower, float upper);
+void rf_fill_double(RFState *state, double *out, size_t n, double lower, double upper);
+
+// Multi-lane versions with 4 or 8 independent xoshiro256+ streams
+void rf_seed_x4(RFStateX4 *state, uint64_t seed);
+void rf_seed_x8(RFStateX8 *state, uint64_t seed);
+void rf_fill_float_01_x4(RFStateX4 *state, float *out, size_t n);
+void rf_fill_float_01_x8(RFStateX8 *state, float *out, size_t n);
+void rf_fill_double_01_x4(RFStateX4 *state, double *out, size_t n);
+void rf_fill_double_01_x8(RFStateX8 *state, double *out, size_t n);
+
+// Same as the four functions above, but pick the fastest instruction set the
+// CPU supports at run time. They are only compiled in the file that defines
+// RANDOM_IMPLEMENTATION. rf_dispatch_target returns the name of the instruction
+// set that was picked.
+void rf_fill_float_01_x4_dispatch(RFStateX4 *state, float *out, size_t n);
+void rf_fill_float_01_x8_dispatch(RFStateX8 *state, float *out, size_t n);
+void rf_fill_double_01_x4_dispatch(RFStateX4 *state, double *out, size_t n);
+void rf_fill_double_01_x8_dispatch(RFStateX8 *state, double *out, size_t n);
+const char *rf_dispatch_target(void);
 
 // Sample a normal distribution with the given mean and standard deviation
 float rf_float_gaussian(RFState *state, float mu, float sigma);
 double rf_double_gaussian(RFState *state, double mu, double sigma);
+void rf_fill_float_gaussian(RFState *state, float *out, size_t n, float mu, float sigma);
+void rf_fill_double_gaussian(RFState *state, double *out, size_t n, double mu, double sigma);
+
+// Sample two independent values from a normal distribution with the polar
+// method, out[0] and out[1] use the same mean and standard deviation
+void rf_float_gaussian_pair(RFState *state, float mu, float sigma, float out[2]);
+void rf_double_gaussian_pair(RFState *state, double mu, double sigma, double out[2]);
+
+// Same as above, but keeps the second value of each pair in the cache and
+// returns it on the next call. The cache has to be zero initialized.
+float rf_float_gaussian_cached(RFState *state, RFGaussianCache *cache, float mu, float sigma);
+double rf_double_gaussian_cached(RFState *state, RFGaussianCache *cache, double mu, double sigma);
+
+// Only with RANDOM_STATS, see below. The counters are per thread. rf_stats_dump
+// prints the given counters, or the calling thread's if stats is NULL.
+void rf_stats_get(RFStats *stats);
+void rf_stats_reset(void);
+void rf_stats_dump(FILE *file, const RFStats *stats);
+
+
+The rf_fill_* functions write n values to out. They work on a local copy of the
+state so it can stay in registers for the whole buffer, and produce the same
+sequence as calling the matching single value function n times, with two
+exceptions. The float fills use both halves of each output, and match calling
+rf_float2_01 n / 2 times, followed by one rf_float_01 call if n is odd. The
+Gaussian fills work in blocks: they first take the fast path of the Ziggurat
+method for the whole block without branching, and then run the slow path for the
+few values that need it. The distribution is the same, but the values differ
+from calling the single value function.
+
+rf_float_01 and rf_double_01 return multiples of 2^-24 and 2^-53. The _fast
+versions set the exponent bits of 1.0 and subtract 1, giving multiples of 2^-23
+and 2^-52. This trades one bit of precision for skipping the int to float
+conversion, which helps on targets where that conversion is slow or doesn't
+vectorize; on x86-64 the difference is small. The _full versions pick the
+exponent from the leading zeros of an extra output, so values below 2^-53 are
+sampled as finely as the type allows, which matters when the result is used in
+e.g. log(x) or 1 / x. They take at least two outputs per value.
+
+The multi-lane states store the lanes in structure-of-arrays layout, so one
+step of every lane maps onto a few vector instructions. AVX2 and AVX-512 are
+used when the compiler targets them (e.g. -mavx2 or -march=native), otherwise
+the lanes are stepped in a plain loop that the compiler is free to vectorize
+for the target, e.g. with NEON. Lane 0 produces the same sequence as an RFState
+seeded with the same seed, and every following lane starts one jump after the
+previous one. The fill functions write one step of every lane at a time, lane
+by lane, and the float fills write both values of rf_float2_01 for each lane.
+Outputs of the last step that don't fit in n are discarded.
+
+The _dispatch versions of the multi-lane fills are for binaries that run on
+several kinds of x86 CPUs and can't be compiled for AVX2 or AVX-512. They work
+like the random.h ones: define RANDOM_IMPLEMENTATION in one C or C++ file before
+including random_float.h, and with GCC and Clang on x86 a constructor picks
+generic, AVX2 or AVX-512 lane stepping at startup. The conversions to float and
+double stay in plain C, and the results are the same on every CPU and match the
+inline fills. Elsewhere they call the inline versions.
+
+RFState is 32 bytes, so two states in an array share a cache line, which slows
+down threads that use adjacent states. RFStateAligned pads the state to a full
+cache line to avoid this, and rf_alloc_states allocates aligned arrays of them.
+The line size is 64 bytes, unless RANDOM_CACHE_LINE is defined as something
+else (e.g. 128, for CPUs that prefetch pairs of lines) before including this
+file. It has to be a power of two of at least 32.
+
+Under CUDA and HIP, the generator, jumps and uniform conversions are __host__
+__device__ functions: rf_seed, rf__next, rf_jump, rf_long_jump, the _01 and
+_01_fast functions and rf_float2_01. They give bit for bit the same results on
+the device as on the host. rf_float and rf_double do as well, as long as neither
+compiler fuses the multiply and add (e.g. nvcc -fmad=false). The macro
+RANDOM_HOST_DEVICE holds the qualifiers, and can be defined before including
+this file for other compilers. The Gaussian functions stay host only, since the
+Ziggurat tables are host data and the device math library doesn't round like the
+host one. RFStateSoA stores n states as four arrays of n words, so that the
+states of neighboring threads are next to each other in device memory. Seed it
+on the host with rf_seed_soa, where state i starts i jumps after the seed, and
+copy it to the device. In a kernel, rf_load_soa copies state i into a local
+state, and rf_store_soa writes it back.
+
+Saved states use a fixed format: an 8 byte tag followed by the four state words
+of each state, in little endian byte order, so checkpoints can be moved between
+machines. A multi-lane state is saved as one state per lane. On little endian
+machines the state words are stored as they are in memory, so the load functions
+compile to a plain copy plus the validity checks.
+
+Defining RANDOM_STATS in every file that includes random_float.h, e.g. with
+-DRANDOM_STATS, counts the generator steps, the candidates of the Gaussian
+functions and how many values take the slow path of the Ziggurat method. The
+counters are thread local, so they don't change the size of RFState, and one C
+or C++ file has to define them by defining RANDOM_IMPLEMENTATION before
+including this file:
+
+    #define RANDOM_IMPLEMENTATION
+    #include "random_float.h"
+
+Jumps count as the 256 steps they take. Counting slows down the fast paths, so
+it's meant for profiling builds. Without RANDOM_STATS there is no counting code
+at all. The counters are shared with random.h, which also counts its range
+functions, and only one file in a program may define RANDOM_IMPLEMENTATION.
+
+random.h and random_float.h share one implementation of the seeding, jumps,
+multi-lane stepping, conversions and Gaussian sampling, which only differs in
+the output function of the generator. RFState and RandomState are the same type,
+so a state can be used with the functions from both headers, and including both
+only compiles the shared code once. Both headers are still standalone, but they
+have to come from the same release.
 
 
 Changelog:
 
+1.1:
+  - Added bulk rf_fill_* functions.
+  - Added multi-lane RFStateX4 and RFStateX8.
+  - Added rf_jump and rf_long_jump.
+  - Switched the Gaussian functions to the Ziggurat method. The previous loop
+    only drew one uniform per sample and didn't produce a normal distribution.
+  - Added polar method rf_float_gaussian_pair, rf_double_gaussian_pair and
+    the cached versions using RFGaussianCache.
+  - Made the float conversions use 32 bit int to float conversions.
+  - Added rf_fill_float_gaussian and rf_fill_double_gaussian.
+  - Shared the generator core with random.h, RFState and RandomState are now
+    the same type.
+  - Added rf_float2_01, the float fills now take two values from each output.
+  - Added RFStateAligned, RANDOM_CACHE_LINE, rf_alloc_states and rf_free_states.
+  - Added rf_state_save, rf_state_load and the bulk versions.
+  - Added the _01_fast and _01_full float and double functions.
+  - Added RANDOM_IMPLEMENTATION and the _dispatch multi-lane fills.
+  - Added the RANDOM_STATS counters.
+  - Added RANDOM_HOST_DEVICE for CUDA and HIP, and RFStateSoA.
 1.0:
   - Initial release.
 
@@ -41,94 +226,1552 @@ Changelog:
 #ifndef RANDOM_FLOAT_H_INCLUDE
 #define RANDOM_FLOAT_H_INCLUDE
 
+#if defined(__AVX2__) || defined(__AVX512F__) || \
+    (defined(RANDOM_IMPLEMENTATION) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)))
+#include <immintrin.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#include <stddef.h>
 #include <stdint.h>
+#include <assert.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef RANDOM_STATS
+#include <stdio.h>
+#endif
+
+// The core below is shared by random.h and random_float.h. Both headers contain
+// an identical copy of it, so a translation unit that includes both only gets
+// one. xoshiro256++ and xoshiro256+ use the same state transition and only
+// differ in how the output is computed from the state, so the core functions
+// take a plain state array and a scrambler, which is always a constant and gets
+// folded away when they are inlined.
+#ifndef RANDOM__CORE_INCLUDE
+#define RANDOM__CORE_INCLUDE
+#define RANDOM__CORE_VERSION 1
+
+// Qualifies the functions that can also run on a GPU: the generator, jumps and
+// conversions, and the functions built only on those. They don't use static
+// data, so CUDA and HIP can compile them for the device.
+#ifndef RANDOM_HOST_DEVICE
+#if defined(__CUDACC__) || defined(__HIPCC__)
+#define RANDOM_HOST_DEVICE __host__ __device__
+#else
+#define RANDOM_HOST_DEVICE
+#endif
+#endif
+
+// Scramblers
+#define RANDOM__PLUS 0       // xoshiro256+, used by random_float.h
+#define RANDOM__PLUS_PLUS 1  // xoshiro256++, used by random.h
 
+// Aligns a variable or struct member to n bytes
+#if defined(__cplusplus) && __cplusplus >= 201103L
+#define RANDOM__ALIGN(n) alignas(n)
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#define RANDOM__ALIGN(n) _Alignas(n)
+#elif defined(__GNUC__)
+#define RANDOM__ALIGN(n) __attribute__((aligned(n)))
+#elif defined(_MSC_VER)
+#define RANDOM__ALIGN(n) __declspec(align(n))
+#else
+#error "No way to align types is known for this compiler"
+#endif
+
+// Alignment of the aligned state types and buffers. Define this as 128 before
+// including the headers on CPUs that fetch cache lines in pairs.
+#ifndef RANDOM_CACHE_LINE
+#define RANDOM_CACHE_LINE 64
+#endif
+
+// State types shared by both headers, see RandomState and RFState
 typedef struct {
     uint64_t s[4];
-} RFState;
+} Random__State;
+
+// Multi-lane states, s[i][lane] is word i of the given lane's state
+typedef struct {
+    uint64_t s[4][4];
+} Random__StateX4;
+
+typedef struct {
+    uint64_t s[4][8];
+} Random__StateX8;
+
+// A state on its own cache line
+typedef struct {
+    RANDOM__ALIGN(RANDOM_CACHE_LINE) Random__State state;
+} Random__StateAligned;
+
+// Fails to compile if the alignment didn't take effect, or if RANDOM_CACHE_LINE
+// isn't a power of two of at least 32, the size of the state
+typedef char random__check_state_aligned[sizeof(Random__StateAligned) == RANDOM_CACHE_LINE ? 1 : -1];
+
+// n states in structure-of-arrays layout, word i of state t is s[i * n + t].
+// With one state per GPU thread, neighboring threads then access neighboring
+// words, which coalesces the loads and stores.
+typedef struct {
+    uint64_t *s;
+    size_t n;
+} Random__StateSoA;
+
+// Holds the second standard normal value of the last polar method pair
+typedef struct {
+    double spare;
+    int has_spare;
+} Random__GaussianCache;
+
+// Counters for RANDOM_STATS, one set per thread. They are defined in the file
+// that defines RANDOM_IMPLEMENTATION.
+typedef struct {
+    uint64_t steps;                // Generator steps, counting every lane
+    uint64_t range_samples;        // Values from the range functions
+    uint64_t range_candidates;     // Outputs they tried, including rejected ones
+    uint64_t range_divisions;      // Divisions they did
+    uint64_t gaussian_samples;     // Values from the Gaussian functions
+    uint64_t gaussian_slow;        // Ziggurat values that took the slow path
+    uint64_t gaussian_candidates;  // Values they tried, including rejected ones
+} Random__Stats;
+
+// Device code can't reach the host's thread local counters, so it doesn't count
+#if defined(RANDOM_STATS) && !defined(__CUDA_ARCH__) && !defined(__HIP_DEVICE_COMPILE__)
+#if defined(__GNUC__)
+#define RANDOM__THREAD_LOCAL __thread
+#elif defined(_MSC_VER)
+#define RANDOM__THREAD_LOCAL __declspec(thread)
+#elif defined(__cplusplus) && __cplusplus >= 201103L
+#define RANDOM__THREAD_LOCAL thread_local
+#else
+#define RANDOM__THREAD_LOCAL _Thread_local
+#endif
+
+extern RANDOM__THREAD_LOCAL Random__Stats random__stats;
+#define RANDOM__STAT(name, n) ((void)(random__stats.name += (n)))
+#else
+#define RANDOM__STAT(name, n) ((void)0)
+#endif
 
 // SplitMix64 implementation based on the one by Sebastiano Vigna:
 //     https://prng.di.unimi.it/splitmix64.c
 // This is only used to seed the RNG.
-static inline uint64_t rf__split_mix_64(uint64_t x) {
+RANDOM_HOST_DEVICE static inline uint64_t random__split_mix_64(uint64_t x) {
     x += 0x9e3779b97f4a7c15;
     x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
     x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
     return x ^ (x >> 31);
 }
 
-static inline void rf_seed(RFState *state, uint64_t seed) {
-    state->s[0] = (seed = rf__split_mix_64(seed));
-    state->s[1] = (seed = rf__split_mix_64(seed));
-    state->s[2] = (seed = rf__split_mix_64(seed));
-    state->s[3] = (seed = rf__split_mix_64(seed));
+RANDOM_HOST_DEVICE static inline void random__seed(uint64_t s[4], uint64_t seed) {
+    s[0] = (seed = random__split_mix_64(seed));
+    s[1] = (seed = random__split_mix_64(seed));
+    s[2] = (seed = random__split_mix_64(seed));
+    s[3] = (seed = random__split_mix_64(seed));
+}
+
+RANDOM_HOST_DEVICE static inline uint64_t random__rotl(const uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
 }
 
-// xoshiro256+ implementation based on the one by David Blackman and Sebastiano Vigna:
+// xoshiro256++ and xoshiro256+ implementation based on the ones by David Blackman
+// and Sebastiano Vigna:
+//     https://prng.di.unimi.it/xoshiro256plusplus.c
 //     https://prng.di.unimi.it/xoshiro256plus.c
-static inline uint64_t rf__next(RFState *state) {
-    const uint64_t result = state->s[0] + state->s[3];
-    const uint64_t t = state->s[1] << 17;
+RANDOM_HOST_DEVICE static inline uint64_t random__next(uint64_t s[4], int scrambler) {
+    RANDOM__STAT(steps, 1);
+    const uint64_t result = scrambler == RANDOM__PLUS_PLUS
+        ? random__rotl(s[0] + s[3], 23) + s[0]
+        : s[0] + s[3];
+    const uint64_t t = s[1] << 17;
 
-    state->s[2] ^= state->s[0];
-    state->s[3] ^= state->s[1];
-    state->s[1] ^= state->s[2];
-    state->s[0] ^= state->s[3];
-    state->s[2] ^= t;
-    state->s[3] = (state->s[3] << 45) | (state->s[3] >> 19);
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = random__rotl(s[3], 45);
 
     return result;
 }
 
-static inline float rf_float_01(RFState *state) {
-    return 0x1p-24f * (rf__next(state) >> 40);
+// Jump functions based on the ones by David Blackman and Sebastiano Vigna, see
+// the reference implementations above. They only depend on the state
+// transition, so they are the same for both scramblers. Each one is equivalent
+// to 2^128 or 2^192 calls to random__next.
+RANDOM_HOST_DEVICE static inline void random__jump_poly(uint64_t s[4], const uint64_t poly[4]) {
+    uint64_t s0 = 0;
+    uint64_t s1 = 0;
+    uint64_t s2 = 0;
+    uint64_t s3 = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (poly[i] & ((uint64_t)1 << b)) {
+                s0 ^= s[0];
+                s1 ^= s[1];
+                s2 ^= s[2];
+                s3 ^= s[3];
+            }
+            random__next(s, RANDOM__PLUS);
+        }
+    }
+
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
 }
 
-static inline double rf_double_01(RFState *state) {
-    return 0x1p-53 * (rf__next(state) >> 11);
+RANDOM_HOST_DEVICE static inline void random__jump(uint64_t s[4]) {
+    const uint64_t JUMP[4] = {
+        0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c
+    };
+    random__jump_poly(s, JUMP);
 }
 
-static inline float rf_float(RFState *state, float lower, float upper) {
-    return lower + (upper - lower) * rf_float_01(state);
+RANDOM_HOST_DEVICE static inline void random__long_jump(uint64_t s[4]) {
+    const uint64_t LONG_JUMP[4] = {
+        0x76e15d3efefdcbbf, 0xc5004e441c522fb3, 0x77710069854ee241, 0x39109bb02acbe635
+    };
+    random__jump_poly(s, LONG_JUMP);
 }
 
-static inline double rf_double(RFState *state, double lower, double upper) {
-    return lower + (upper - lower) * rf_double_01(state);
+// Allocates size bytes aligned to RANDOM_CACHE_LINE. The pointer returned by
+// malloc is stored right before the aligned block.
+static inline void *random__aligned_alloc(size_t size) {
+    const size_t align = RANDOM_CACHE_LINE;
+    if (size > (size_t)-1 - align - sizeof(void *)) {
+        return NULL;
+    }
+
+    void *base = malloc(size + align - 1 + sizeof(void *));
+    if (!base) {
+        return NULL;
+    }
+
+    const uintptr_t p = ((uintptr_t)base + sizeof(void *) + align - 1) & ~(uintptr_t)(align - 1);
+    ((void **)p)[-1] = base;
+    return (void *)p;
 }
 
-static inline float rf_float_gaussian(RFState *state, float mu, float sigma) {
+static inline void random__aligned_free(void *p) {
+    if (p) {
+        free(((void **)p)[-1]);
+    }
+}
+
+// State i starts i jumps after a state seeded with seed
+static inline Random__StateAligned *random__alloc_states(size_t n, uint64_t seed) {
+    if (n > (size_t)-1 / sizeof(Random__StateAligned)) {
+        return NULL;
+    }
+
+    Random__StateAligned *states = (Random__StateAligned *)random__aligned_alloc(n * sizeof(Random__StateAligned));
+    if (!states) {
+        return NULL;
+    }
+
+    uint64_t s[4];
+    random__seed(s, seed);
+    for (size_t i = 0; i < n; i++) {
+        for (int j = 0; j < 4; j++) {
+            states[i].state.s[j] = s[j];
+        }
+        random__jump(s);
+    }
+    return states;
+}
+
+// Seeds the states like random__alloc_states, state t starts t jumps after a
+// state seeded with seed
+static inline void random__seed_soa(Random__StateSoA *soa, uint64_t seed) {
+    uint64_t s[4];
+    random__seed(s, seed);
+    for (size_t t = 0; t < soa->n; t++) {
+        for (int i = 0; i < 4; i++) {
+            soa->s[i * soa->n + t] = s[i];
+        }
+        random__jump(s);
+    }
+}
+
+RANDOM_HOST_DEVICE static inline void random__load_soa(const Random__StateSoA *soa, size_t t, uint64_t s[4]) {
+    for (int i = 0; i < 4; i++) {
+        s[i] = soa->s[i * soa->n + t];
+    }
+}
+
+RANDOM_HOST_DEVICE static inline void random__store_soa(Random__StateSoA *soa, size_t t, const uint64_t s[4]) {
+    for (int i = 0; i < 4; i++) {
+        soa->s[i * soa->n + t] = s[i];
+    }
+}
+
+// Checkpoint format: an 8 byte tag followed by 32 bytes per state, the four
+// state words in order, each in little endian byte order
+#define RANDOM_STATES_BYTES(n) (8 + 32 * (size_t)(n))
+#define RANDOM_STATE_BYTES RANDOM_STATES_BYTES(1)
+
+static const unsigned char random__state_tag[8] = {'x', 'o', '2', '5', '6', 0, 0, 1};
+
+// Written out so that compilers turn them into a single load or store on little
+// endian targets
+static inline void random__store_le64(unsigned char *out, uint64_t x) {
+    out[0] = (unsigned char)x;
+    out[1] = (unsigned char)(x >> 8);
+    out[2] = (unsigned char)(x >> 16);
+    out[3] = (unsigned char)(x >> 24);
+    out[4] = (unsigned char)(x >> 32);
+    out[5] = (unsigned char)(x >> 40);
+    out[6] = (unsigned char)(x >> 48);
+    out[7] = (unsigned char)(x >> 56);
+}
+
+static inline uint64_t random__load_le64(const unsigned char *in) {
+    return (uint64_t)in[0] | ((uint64_t)in[1] << 8) | ((uint64_t)in[2] << 16) | ((uint64_t)in[3] << 24) |
+           ((uint64_t)in[4] << 32) | ((uint64_t)in[5] << 40) | ((uint64_t)in[6] << 48) | ((uint64_t)in[7] << 56);
+}
+
+// Saves n states, where word j of state i is at base + i * stride + j * step,
+// in bytes. This covers arrays of states with any padding (step 8) as well as
+// multi-lane states (stride 8, step 8 * lanes).
+static inline void random__states_save(const void *base, size_t n, size_t stride, size_t step,
+                                       unsigned char *out) {
+    const unsigned char *p = (const unsigned char *)base;
+    memcpy(out, random__state_tag, 8);
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            random__store_le64(out + 8 + 32 * i + 8 * j, *(const uint64_t *)(p + i * stride + j * step));
+        }
+    }
+}
+
+// Returns -1 without changing the states if the tag doesn't match or one of
+// the states is all zero, which xoshiro can't leave
+static inline int random__states_load(void *base, size_t n, size_t stride, size_t step, const unsigned char *in) {
+    unsigned char *p = (unsigned char *)base;
+    if (memcmp(in, random__state_tag, 8) != 0) {
+        return -1;
+    }
+    for (size_t i = 0; i < n; i++) {
+        uint64_t any = 0;
+        for (size_t j = 0; j < 4; j++) {
+            any |= random__load_le64(in + 8 + 32 * i + 8 * j);
+        }
+        if (any == 0) {
+            return -1;
+        }
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < 4; j++) {
+            *(uint64_t *)(p + i * stride + j * step) = random__load_le64(in + 8 + 32 * i + 8 * j);
+        }
+    }
+    return 0;
+}
+
+// The value fits in 24 bits, so going through int32_t gives the compiler a
+// plain 32 bit int to float conversion, which vectorizes.
+RANDOM_HOST_DEVICE static inline float random__to_float_01(uint64_t x) {
+    return 0x1p-24f * (float)(int32_t)(x >> 40);
+}
+
+// Second float from the same output, for generating two floats at once. This
+// uses bits 16 to 39, which are independent of the ones used above and clear of
+// the weak low bits of xoshiro256+.
+RANDOM_HOST_DEVICE static inline float random__to_float_01_low(uint64_t x) {
+    return 0x1p-24f * (float)(int32_t)((x >> 16) & 0xffffff);
+}
+
+RANDOM_HOST_DEVICE static inline double random__to_double_01(uint64_t x) {
+    return 0x1p-53 * (x >> 11);
+}
+
+// Builds the float in [1, 2) from 23 or 52 random mantissa bits and subtracts
+// 1. This saves the int to float conversion, but gives one bit less precision.
+RANDOM_HOST_DEVICE static inline float random__to_float_01_fast(uint64_t x) {
+    const uint32_t bits = (uint32_t)(x >> 41) | 0x3f800000;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f - 1.0f;
+}
+
+RANDOM_HOST_DEVICE static inline double random__to_double_01_fast(uint64_t x) {
+    const uint64_t bits = (x >> 12) | 0x3ff0000000000000;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d - 1.0;
+}
+
+// Number of leading zero bits, x != 0
+static inline int random__clz64(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_clzll(x);
+#else
+    int n = 0;
+    while (!(x & ((uint64_t)1 << 63))) {
+        x <<= 1;
+        n++;
+    }
+    return n;
+#endif
+}
+
+// Returns e such that the result lies in [2^e, 2^(e + 1)), with probability
+// 2^e, by counting the leading zeros of as many outputs as needed. Stops at
+// min_e, which stands for the subnormal range [0, 2^(min_e + 1)) of the
+// caller's type.
+static inline int random__exponent_01(uint64_t s[4], int scrambler, int min_e) {
+    int e = -1;
+    for (;;) {
+        const uint64_t y = random__next(s, scrambler);
+        if (y != 0) {
+            e -= random__clz64(y);
+            return e < min_e ? min_e : e;
+        }
+        e -= 64;
+        if (e < min_e) {
+            return min_e;
+        }
+    }
+}
+
+// Full precision uniforms: every float or double in [0, 1) can be returned, with
+// a probability proportional to the gap to the next one. The mantissa comes
+// from one output and the exponent from at least one more.
+static inline float random__float_01_full(uint64_t s[4], int scrambler) {
+    const uint32_t mantissa = (uint32_t)(random__next(s, scrambler) >> 41);
+    const int e = random__exponent_01(s, scrambler, -127);
+
+    // A zero exponent field makes the mantissa a subnormal, uniform in
+    // [0, 2^-126)
+    const uint32_t bits = ((uint32_t)(e < -126 ? 0 : 127 + e) << 23) | mantissa;
+    float f;
+    memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+static inline double random__double_01_full(uint64_t s[4], int scrambler) {
+    const uint64_t mantissa = random__next(s, scrambler) >> 12;
+    const int e = random__exponent_01(s, scrambler, -1023);
+    const uint64_t bits = ((uint64_t)(e < -1022 ? 0 : 1023 + e) << 52) | mantissa;
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// Multi-lane states are stored as s[i][lane]. The lane functions take pointers
+// s0..s3 to the first lane's state words. Lane 0 is seeded like a scalar state
+// and every following lane starts one jump after the previous one.
+static inline void random__seed_lanes(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3,
+                                      int lanes, uint64_t seed) {
+    uint64_t s[4];
+    random__seed(s, seed);
+    for (int i = 0; i < lanes; i++) {
+        s0[i] = s[0];
+        s1[i] = s[1];
+        s2[i] = s[2];
+        s3[i] = s[3];
+        random__jump(s);
+    }
+}
+
+// Steps the given number of lanes
+static inline void random__next_lanes(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3,
+                                      uint64_t *out, int lanes, int scrambler) {
+    for (int i = 0; i < lanes; i++) {
+        const uint64_t result = scrambler == RANDOM__PLUS_PLUS
+            ? random__rotl(s0[i] + s3[i], 23) + s0[i]
+            : s0[i] + s3[i];
+        const uint64_t t = s1[i] << 17;
+
+        s2[i] ^= s0[i];
+        s3[i] ^= s1[i];
+        s1[i] ^= s2[i];
+        s0[i] ^= s3[i];
+        s2[i] ^= t;
+        s3[i] = random__rotl(s3[i], 45);
+
+        out[i] = result;
+    }
+}
+
+// The RANDOM_IMPLEMENTATION blocks of random.h and random_float.h pick the AVX2
+// or AVX-512 lane functions at run time. GCC and Clang can compile them for
+// those targets with function attributes, even when the rest of the file isn't.
+#if defined(RANDOM_IMPLEMENTATION) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RANDOM__DISPATCH
+#define RANDOM__TARGET_AVX2 __attribute__((target("avx2")))
+#define RANDOM__TARGET_AVX512 __attribute__((target("avx512f")))
+#else
+#define RANDOM__TARGET_AVX2
+#define RANDOM__TARGET_AVX512
+#endif
+
+#if defined(__AVX2__) || defined(RANDOM__DISPATCH)
+RANDOM__TARGET_AVX2 static inline __m256i random__rotl_avx2(__m256i x, int k) {
+    return _mm256_or_si256(_mm256_slli_epi64(x, k), _mm256_srli_epi64(x, 64 - k));
+}
+
+// Same as random__next_lanes for 4 lanes
+RANDOM__TARGET_AVX2 static inline void random__next_lanes_avx2(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3,
+                                           uint64_t *out, int scrambler) {
+    __m256i v0 = _mm256_loadu_si256((const __m256i *)s0);
+    __m256i v1 = _mm256_loadu_si256((const __m256i *)s1);
+    __m256i v2 = _mm256_loadu_si256((const __m256i *)s2);
+    __m256i v3 = _mm256_loadu_si256((const __m256i *)s3);
+
+    const __m256i result = scrambler == RANDOM__PLUS_PLUS
+        ? _mm256_add_epi64(random__rotl_avx2(_mm256_add_epi64(v0, v3), 23), v0)
+        : _mm256_add_epi64(v0, v3);
+    const __m256i t = _mm256_slli_epi64(v1, 17);
+
+    v2 = _mm256_xor_si256(v2, v0);
+    v3 = _mm256_xor_si256(v3, v1);
+    v1 = _mm256_xor_si256(v1, v2);
+    v0 = _mm256_xor_si256(v0, v3);
+    v2 = _mm256_xor_si256(v2, t);
+    v3 = random__rotl_avx2(v3, 45);
+
+    _mm256_storeu_si256((__m256i *)s0, v0);
+    _mm256_storeu_si256((__m256i *)s1, v1);
+    _mm256_storeu_si256((__m256i *)s2, v2);
+    _mm256_storeu_si256((__m256i *)s3, v3);
+    _mm256_storeu_si256((__m256i *)out, result);
+}
+#endif
+
+#if defined(__AVX512F__) || defined(RANDOM__DISPATCH)
+// GCC 12 warns about the undefined vectors that avx512fintrin.h passes to its
+// masked builtins, wherever this gets inlined
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// Same as random__next_lanes for 8 lanes
+RANDOM__TARGET_AVX512 static inline void random__next_lanes_avx512(uint64_t *s0, uint64_t *s1, uint64_t *s2, uint64_t *s3,
+                                             uint64_t *out, int scrambler) {
+    __m512i v0 = _mm512_loadu_si512((const void *)s0);
+    __m512i v1 = _mm512_loadu_si512((const void *)s1);
+    __m512i v2 = _mm512_loadu_si512((const void *)s2);
+    __m512i v3 = _mm512_loadu_si512((const void *)s3);
+
+    const __m512i result = scrambler == RANDOM__PLUS_PLUS
+        ? _mm512_add_epi64(_mm512_rol_epi64(_mm512_add_epi64(v0, v3), 23), v0)
+        : _mm512_add_epi64(v0, v3);
+    const __m512i t = _mm512_slli_epi64(v1, 17);
+
+    v2 = _mm512_xor_si512(v2, v0);
+    v3 = _mm512_xor_si512(v3, v1);
+    v1 = _mm512_xor_si512(v1, v2);
+    v0 = _mm512_xor_si512(v0, v3);
+    v2 = _mm512_xor_si512(v2, t);
+    v3 = _mm512_rol_epi64(v3, 45);
+
+    _mm512_storeu_si512((void *)s0, v0);
+    _mm512_storeu_si512((void *)s1, v1);
+    _mm512_storeu_si512((void *)s2, v2);
+    _mm512_storeu_si512((void *)s3, v3);
+    _mm512_storeu_si512((void *)out, result);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+static inline void random__next_x4(uint64_t s[4][4], uint64_t out[4], int scrambler) {
+    RANDOM__STAT(steps, 4);
+#if defined(__AVX2__)
+    random__next_lanes_avx2(s[0], s[1], s[2], s[3], out, scrambler);
+#else
+    random__next_lanes(s[0], s[1], s[2], s[3], out, 4, scrambler);
+#endif
+}
+
+static inline void random__next_x8(uint64_t s[4][8], uint64_t out[8], int scrambler) {
+    RANDOM__STAT(steps, 8);
+#if defined(__AVX512F__)
+    random__next_lanes_avx512(s[0], s[1], s[2], s[3], out, scrambler);
+#elif defined(__AVX2__)
+    random__next_lanes_avx2(s[0], s[1], s[2], s[3], out, scrambler);
+    random__next_lanes_avx2(s[0] + 4, s[1] + 4, s[2] + 4, s[3] + 4, out + 4, scrambler);
+#else
+    random__next_lanes(s[0], s[1], s[2], s[3], out, 8, scrambler);
+#endif
+}
+
+// Number of values the Gaussian fill functions generate per block
+#define RANDOM__GAUSSIAN_BLOCK 256
+
+// Ziggurat method for sampling a normal distribution, based on the ZIGNOR
+// variant by Jurgen A. Doornik:
+//     https://www.doornik.com/research/ziggurat.pdf
+// The density is covered by 128 layers of equal area. X[i] is the right edge of
+// layer i, and R[i] = X[i + 1] / X[i] is the fraction of the layer that lies
+// entirely below the curve. Most samples are accepted after one table lookup,
+// a multiply and a compare, the rest fall back to the slow path.
+static const double random__zig_x[129] = {
+    3.7130862467425505, 3.4426198558990002, 3.2230849845811416, 3.0832288582168683,
+    2.9786962526477803, 2.8943440070215289, 2.8231253505489105, 2.7611693723871769,
+    2.7061135731218195, 2.6564064112613597, 2.6109722484318474, 2.5690336259249378,
+    2.5300096723888275, 2.4934545220953721, 2.4590181774118305, 2.4264206455337498,
+    2.3954342780110625, 2.3658713701176386, 2.3375752413392368, 2.310413683698763,
+    2.2842740596774718, 2.2590595738691985, 2.2346863955909795, 2.2110814088787034,
+    2.1881804320760492, 2.1659267937489219, 2.1442701823603953, 2.1231657086739766,
+    2.1025731351892385, 2.0824562379920168, 2.0627822745083084, 2.0435215366550676,
+    2.0246469733773855, 2.0061338699634721, 1.9879595741276199, 1.9701032608543265,
+    1.9525457295535567, 1.9352692282966228, 1.9182573008645099, 1.9014946531051511,
+    1.884967035707759, 1.8686611409944887, 1.8525645117280911, 1.836665460258446,
+    1.8209529965961255, 1.8054167642192285, 1.7900469825998586, 1.7748343955860695,
+    1.7597702248995934, 1.7448461281138004, 1.7300541605637305, 1.7153867407136676,
+    1.7008366185699169, 1.6863968467791681, 1.6720607540976009, 1.6578219209540241,
+    1.6436741568628686, 1.6296114794706347, 1.615628095043161, 1.6017183802213781,
+    1.5878768648905761, 1.5740982160230008, 1.5603772223661689, 1.5467087798599104,
+    1.5330878776740433, 1.5195095847659401, 1.5059690368632033, 1.492461423781354,
+    1.4789819769899242, 1.4655259573427108, 1.4520886428892246, 1.4386653166845635,
+    1.4252512545140601, 1.4118417124470577, 1.3984319141310053, 1.3850170377326518,
+    1.3715922024273426, 1.3581524543301435, 1.344692751753547, 1.3312079496656273,
+    1.3176927832094141, 1.3041418501286168, 1.2905495919261964, 1.2769102735601556,
+    1.2632179614546211, 1.2494664995730682, 1.2356494832633627, 1.2217602305399964,
+    1.2077917504159497, 1.1937367078331287, 1.1795873846639882, 1.1653356361647524,
+    1.1509728421488674, 1.1364898520131608, 1.1218769225825422, 1.107123647534036,
+    1.0922188769072774, 1.0771506248928957, 1.0619059636948243, 1.0464709007640454,
+    1.0308302360681956, 1.0149673952513305, 0.99886423349298359, 0.98250080351542901,
+    0.9658550794011499, 0.94890262551130644, 0.93161619661515083, 0.91396525102303228,
+    0.89591535258093769, 0.87742742911292337, 0.85845684319381321, 0.83895221429757738,
+    0.81885390670035729, 0.79809206064405691, 0.77658398789475991, 0.75423066445405562,
+    0.73091191064248884, 0.70647961133543646, 0.68074791866915463, 0.65347863873997525,
+    0.6243585973360507, 0.59296294247144832, 0.55869217840818519, 0.52065603876206057,
+    0.47743783729668982, 0.42654798635542351, 0.36287143109703196, 0.27232086481396467,
+    0.0
+};
+
+static const double random__zig_r[128] = {
+    0.92715860260966809, 0.93623028957388921, 0.95660799295292287, 0.96609638454488822,
+    0.97168148798278098, 0.97539385218210217, 0.97805411716851776, 0.98006069464048895,
+    0.98163153152396454, 0.98289638112718658, 0.98393754566633251, 0.98480987047335344,
+    0.98555137923289438, 0.98618930308197361, 0.98674367998678636, 0.98722959781119435,
+    0.98765864371032963, 0.98803987015701755, 0.98838045631210891, 0.98868617156930783,
+    0.98896170724285448, 0.98921091831302443, 0.98943700254369094, 0.98964263517811046,
+    0.98983007159696879, 0.99000122651835243, 0.99015773578346966, 0.99030100505080254,
+    0.99043224853369438, 0.99055252008432182, 0.99066273833585672, 0.99076370718921958,
+    0.99085613262097194, 0.99094063656071807, 0.99101776841657896, 0.99108801469971874,
+    0.99115180710216499, 0.99120952930818496, 0.99126152276245516, 0.99130809157396138,
+    0.99134950669991539, 0.99138600952667588, 0.9914178149430195, 0.99144511398384472,
+    0.99146807610853294, 0.99148685116701207, 0.99150157109748349, 0.9915123513923666,
+    0.99151929236293068, 0.99152248022806455, 0.99152198804846459, 0.99151787652404422,
+    0.99151019466943868, 0.99149898038000517, 0.99148426089860509, 0.9914660531916395,
+    0.99144436424122284, 0.99141919125900113, 0.99139052182587151, 0.99135833396074968,
+    0.99132259612049656, 0.99128326713214987, 0.9912402960576856, 0.991193621990624,
+    0.99114317378289896, 0.99108886969948096, 0.99103061699728945, 0.99096831142390407,
+    0.99090183663049125, 0.99083106349214667, 0.9907558493275227, 0.99067603700809548,
+    0.99059145394572945, 0.99050191094523621, 0.99040720090638834, 0.99030709735723799,
+    0.99020135279756305, 0.99008969682771364, 0.98997183403395694, 0.98984744159647786,
+    0.98971616658035255, 0.98957762286281981, 0.98943138764184679, 0.98927699746094222,
+    0.98911394367309524, 0.9889416672520418, 0.98875955284124373, 0.98856692190915973,
+    0.98836302485260341, 0.98814703185694575, 0.98791802228090508, 0.98767497228253098,
+    0.98741674033883642, 0.98714205023059953, 0.98684947096108866, 0.98653739294616549,
+    0.98620399964423899, 0.98584723357553894, 0.98546475539408995, 0.98505389429899071,
+    0.98461158757103473, 0.98413430634945731, 0.98361796385447464, 0.98305780101683371,
+    0.98244824275257281, 0.98178271570611264, 0.98105341485447561, 0.98025100142276667,
+    0.97936420732745055, 0.97837931059633121, 0.97727942988529215, 0.97604356093863154,
+    0.97464523783007639, 0.97305063687522453, 0.97121583268629852, 0.9690827290502092,
+    0.96657285378538182, 0.96357758631187951, 0.95994217656590097, 0.95543841882869618,
+    0.94971534788091627, 0.9422042060159378, 0.93191932674895062, 0.91699279707169312,
+    0.89341051972459762, 0.85071654937943442, 0.75046102138899429, 0.0
+};
+
+static const float random__zig_xf[129] = {
+    3.71308625f, 3.44261986f, 3.22308498f, 3.08322886f, 2.97869625f, 2.89434401f,
+    2.82312535f, 2.76116937f, 2.70611357f, 2.65640641f, 2.61097225f, 2.56903363f,
+    2.53000967f, 2.49345452f, 2.45901818f, 2.42642065f, 2.39543428f, 2.36587137f,
+    2.33757524f, 2.31041368f, 2.28427406f, 2.25905957f, 2.2346864f, 2.21108141f,
+    2.18818043f, 2.16592679f, 2.14427018f, 2.12316571f, 2.10257314f, 2.08245624f,
+    2.06278227f, 2.04352154f, 2.02464697f, 2.00613387f, 1.98795957f, 1.97010326f,
+    1.95254573f, 1.93526923f, 1.9182573f, 1.90149465f, 1.88496704f, 1.86866114f,
+    1.85256451f, 1.83666546f, 1.820953f, 1.80541676f, 1.79004698f, 1.7748344f,
+    1.75977022f, 1.74484613f, 1.73005416f, 1.71538674f, 1.70083662f, 1.68639685f,
+    1.67206075f, 1.65782192f, 1.64367416f, 1.62961148f, 1.6156281f, 1.60171838f,
+    1.58787686f, 1.57409822f, 1.56037722f, 1.54670878f, 1.53308788f, 1.51950958f,
+    1.50596904f, 1.49246142f, 1.47898198f, 1.46552596f, 1.45208864f, 1.43866532f,
+    1.42525125f, 1.41184171f, 1.39843191f, 1.38501704f, 1.3715922f, 1.35815245f,
+    1.34469275f, 1.33120795f, 1.31769278f, 1.30414185f, 1.29054959f, 1.27691027f,
+    1.26321796f, 1.2494665f, 1.23564948f, 1.22176023f, 1.20779175f, 1.19373671f,
+    1.17958738f, 1.16533564f, 1.15097284f, 1.13648985f, 1.12187692f, 1.10712365f,
+    1.09221888f, 1.07715062f, 1.06190596f, 1.0464709f, 1.03083024f, 1.0149674f,
+    0.998864233f, 0.982500804f, 0.965855079f, 0.948902626f, 0.931616197f, 0.913965251f,
+    0.895915353f, 0.877427429f, 0.858456843f, 0.838952214f, 0.818853907f, 0.798092061f,
+    0.776583988f, 0.754230664f, 0.730911911f, 0.706479611f, 0.680747919f, 0.653478639f,
+    0.624358597f, 0.592962942f, 0.558692178f, 0.520656039f, 0.477437837f, 0.426547986f,
+    0.362871431f, 0.272320865f, 0.0f
+};
+
+static const float random__zig_rf[128] = {
+    0.927158603f, 0.93623029f, 0.956607993f, 0.966096385f, 0.971681488f, 0.975393852f,
+    0.978054117f, 0.980060695f, 0.981631532f, 0.982896381f, 0.983937546f, 0.98480987f,
+    0.985551379f, 0.986189303f, 0.98674368f, 0.987229598f, 0.987658644f, 0.98803987f,
+    0.988380456f, 0.988686172f, 0.988961707f, 0.989210918f, 0.989437003f, 0.989642635f,
+    0.989830072f, 0.990001227f, 0.990157736f, 0.990301005f, 0.990432249f, 0.99055252f,
+    0.990662738f, 0.990763707f, 0.990856133f, 0.990940637f, 0.991017768f, 0.991088015f,
+    0.991151807f, 0.991209529f, 0.991261523f, 0.991308092f, 0.991349507f, 0.99138601f,
+    0.991417815f, 0.991445114f, 0.991468076f, 0.991486851f, 0.991501571f, 0.991512351f,
+    0.991519292f, 0.99152248f, 0.991521988f, 0.991517877f, 0.991510195f, 0.99149898f,
+    0.991484261f, 0.991466053f, 0.991444364f, 0.991419191f, 0.991390522f, 0.991358334f,
+    0.991322596f, 0.991283267f, 0.991240296f, 0.991193622f, 0.991143174f, 0.99108887f,
+    0.991030617f, 0.990968311f, 0.990901837f, 0.990831063f, 0.990755849f, 0.990676037f,
+    0.990591454f, 0.990501911f, 0.990407201f, 0.990307097f, 0.990201353f, 0.990089697f,
+    0.989971834f, 0.989847442f, 0.989716167f, 0.989577623f, 0.989431388f, 0.989276997f,
+    0.989113944f, 0.988941667f, 0.988759553f, 0.988566922f, 0.988363025f, 0.988147032f,
+    0.987918022f, 0.987674972f, 0.98741674f, 0.98714205f, 0.986849471f, 0.986537393f,
+    0.986204f, 0.985847234f, 0.985464755f, 0.985053894f, 0.984611588f, 0.984134306f,
+    0.983617964f, 0.983057801f, 0.982448243f, 0.981782716f, 0.981053415f, 0.980251001f,
+    0.979364207f, 0.978379311f, 0.97727943f, 0.976043561f, 0.974645238f, 0.973050637f,
+    0.971215833f, 0.969082729f, 0.966572854f, 0.963577586f, 0.959942177f, 0.955438419f,
+    0.949715348f, 0.942204206f, 0.931919327f, 0.916992797f, 0.89341052f, 0.850716549f,
+    0.750461021f, 0.0f
+};
+
+// Each sample uses one 64 bit output: the top 7 bits select the layer and the
+// next 54 (or 24 for floats) bits give a signed uniform -1 <= u < 1.
+static inline int random__zig_layer(uint64_t x) {
+    return (int)(x >> 57);
+}
+
+static inline double random__zig_u(uint64_t x) {
+    return 0x1p-53 * (double)(int64_t)((x >> 3) & 0x3fffffffffffff) - 1.0;
+}
+
+static inline float random__zig_uf(uint64_t x) {
+    return 0x1p-23f * (float)(int32_t)((x >> 33) & 0xffffff) - 1.0f;
+}
+
+// Slow path, for when u is outside of the rectangle in layer i
+static inline double random__double_normal_slow(uint64_t s[4], int scrambler, double u, int i) {
+    RANDOM__STAT(gaussian_slow, 1);
+    for (;;) {
+        if (i == 0) {
+            // Sample the tail beyond X[1] using Marsaglia's method
+            const double r = random__zig_x[1];
+            double x, y;
+            do {
+                RANDOM__STAT(gaussian_candidates, 1);
+                x = log(1.0 - random__to_double_01(random__next(s, scrambler))) / r;
+                y = log(1.0 - random__to_double_01(random__next(s, scrambler)));
+            } while (-2.0 * y < x * x);
+
+            return u < 0.0 ? x - r : r - x;
+        }
+
+        const double x = u * random__zig_x[i];
+        const double f0 = exp(-0.5 * (random__zig_x[i] * random__zig_x[i] - x * x));
+        const double f1 = exp(-0.5 * (random__zig_x[i + 1] * random__zig_x[i + 1] - x * x));
+        if (f1 + random__to_double_01(random__next(s, scrambler)) * (f0 - f1) < 1.0) {
+            return x;
+        }
+
+        const uint64_t bits = random__next(s, scrambler);
+        RANDOM__STAT(gaussian_candidates, 1);
+        i = random__zig_layer(bits);
+        u = random__zig_u(bits);
+        if (fabs(u) < random__zig_r[i]) {
+            return u * random__zig_x[i];
+        }
+    }
+}
+
+static inline float random__float_normal_slow(uint64_t s[4], int scrambler, float u, int i) {
+    RANDOM__STAT(gaussian_slow, 1);
+    for (;;) {
+        if (i == 0) {
+            const float r = random__zig_xf[1];
+            float x, y;
+            do {
+                RANDOM__STAT(gaussian_candidates, 1);
+                x = logf(1.0f - random__to_float_01(random__next(s, scrambler))) / r;
+                y = logf(1.0f - random__to_float_01(random__next(s, scrambler)));
+            } while (-2.0f * y < x * x);
+
+            return u < 0.0f ? x - r : r - x;
+        }
+
+        const float x = u * random__zig_xf[i];
+        const float f0 = expf(-0.5f * (random__zig_xf[i] * random__zig_xf[i] - x * x));
+        const float f1 = expf(-0.5f * (random__zig_xf[i + 1] * random__zig_xf[i + 1] - x * x));
+        if (f1 + random__to_float_01(random__next(s, scrambler)) * (f0 - f1) < 1.0f) {
+            return x;
+        }
+
+        const uint64_t bits = random__next(s, scrambler);
+        RANDOM__STAT(gaussian_candidates, 1);
+        i = random__zig_layer(bits);
+        u = random__zig_uf(bits);
+        if (fabsf(u) < random__zig_rf[i]) {
+            return u * random__zig_xf[i];
+        }
+    }
+}
+
+static inline float random__float_normal(uint64_t s[4], int scrambler) {
+    RANDOM__STAT(gaussian_samples, 1);
+    RANDOM__STAT(gaussian_candidates, 1);
+    const uint64_t bits = random__next(s, scrambler);
+    const int i = random__zig_layer(bits);
+    const float u = random__zig_uf(bits);
+    if (fabsf(u) < random__zig_rf[i]) {
+        return u * random__zig_xf[i];
+    }
+
+    return random__float_normal_slow(s, scrambler, u, i);
+}
+
+static inline double random__double_normal(uint64_t s[4], int scrambler) {
+    RANDOM__STAT(gaussian_samples, 1);
+    RANDOM__STAT(gaussian_candidates, 1);
+    const uint64_t bits = random__next(s, scrambler);
+    const int i = random__zig_layer(bits);
+    const double u = random__zig_u(bits);
+    if (fabs(u) < random__zig_r[i]) {
+        return u * random__zig_x[i];
+    }
+
+    return random__double_normal_slow(s, scrambler, u, i);
+}
+
+// The Gaussian fills take the fast path for a whole block without branching,
+// remembering which values need the slow path, and then run the slow path for
+// those.
+static inline void random__fill_float_gaussian(uint64_t state[4], int scrambler, float *out, size_t n,
+                                               float mu, float sigma) {
+    uint64_t s[4] = {state[0], state[1], state[2], state[3]};
+    uint64_t bits[RANDOM__GAUSSIAN_BLOCK];
+    size_t slow[RANDOM__GAUSSIAN_BLOCK];
+    for (size_t start = 0; start < n; start += RANDOM__GAUSSIAN_BLOCK) {
+        const size_t m = n - start < RANDOM__GAUSSIAN_BLOCK ? n - start : RANDOM__GAUSSIAN_BLOCK;
+        float *block = out + start;
+        RANDOM__STAT(gaussian_samples, m);
+        RANDOM__STAT(gaussian_candidates, m);
+        for (size_t j = 0; j < m; j++) {
+            bits[j] = random__next(s, scrambler);
+        }
+
+        size_t n_slow = 0;
+        for (size_t j = 0; j < m; j++) {
+            const int i = random__zig_layer(bits[j]);
+            const float u = random__zig_uf(bits[j]);
+            block[j] = mu + sigma * (u * random__zig_xf[i]);
+            slow[n_slow] = j;
+            n_slow += !(fabsf(u) < random__zig_rf[i]);
+        }
+
+        for (size_t k = 0; k < n_slow; k++) {
+            const size_t j = slow[k];
+            const float x = random__float_normal_slow(s, scrambler, random__zig_uf(bits[j]),
+                                                      random__zig_layer(bits[j]));
+            block[j] = mu + sigma * x;
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        state[i] = s[i];
+    }
+}
+
+static inline void random__fill_double_gaussian(uint64_t state[4], int scrambler, double *out, size_t n,
+                                                double mu, double sigma) {
+    uint64_t s[4] = {state[0], state[1], state[2], state[3]};
+    uint64_t bits[RANDOM__GAUSSIAN_BLOCK];
+    size_t slow[RANDOM__GAUSSIAN_BLOCK];
+    for (size_t start = 0; start < n; start += RANDOM__GAUSSIAN_BLOCK) {
+        const size_t m = n - start < RANDOM__GAUSSIAN_BLOCK ? n - start : RANDOM__GAUSSIAN_BLOCK;
+        double *block = out + start;
+        RANDOM__STAT(gaussian_samples, m);
+        RANDOM__STAT(gaussian_candidates, m);
+        for (size_t j = 0; j < m; j++) {
+            bits[j] = random__next(s, scrambler);
+        }
+
+        size_t n_slow = 0;
+        for (size_t j = 0; j < m; j++) {
+            const int i = random__zig_layer(bits[j]);
+            const double u = random__zig_u(bits[j]);
+            block[j] = mu + sigma * (u * random__zig_x[i]);
+            slow[n_slow] = j;
+            n_slow += !(fabs(u) < random__zig_r[i]);
+        }
+
+        for (size_t k = 0; k < n_slow; k++) {
+            const size_t j = slow[k];
+            const double x = random__double_normal_slow(s, scrambler, random__zig_u(bits[j]),
+                                                        random__zig_layer(bits[j]));
+            block[j] = mu + sigma * x;
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        state[i] = s[i];
+    }
+}
+
+static inline void random__float_gaussian_pair(uint64_t s[4], int scrambler, float mu, float sigma, float out[2]) {
     // See https://en.wikipedia.org/wiki/Marsaglia_polar_method
-    float u, s;
+    float u, v, r;
+    RANDOM__STAT(gaussian_samples, 2);
     do {
-        u = rf_float_01(state) * 2.0 - 1.0;
-        s = u * u;
-    } while (s >= 1.0 || s == 0.0);
+        RANDOM__STAT(gaussian_candidates, 2);
+        u = random__to_float_01(random__next(s, scrambler)) * 2.0f - 1.0f;
+        v = random__to_float_01(random__next(s, scrambler)) * 2.0f - 1.0f;
+        r = u * u + v * v;
+    } while (r >= 1.0f || r == 0.0f);
 
-    return mu + sigma * (u * sqrt(-0.5 * log(s) / s));
+    const float m = sqrtf(-2.0f * logf(r) / r);
+    out[0] = mu + sigma * (u * m);
+    out[1] = mu + sigma * (v * m);
 }
 
-static inline double rf_double_gaussian(RFState *state, double mu, double sigma) {
+static inline void random__double_gaussian_pair(uint64_t s[4], int scrambler, double mu, double sigma, double out[2]) {
     // See https://en.wikipedia.org/wiki/Marsaglia_polar_method
-    double u, s;
+    double u, v, r;
+    RANDOM__STAT(gaussian_samples, 2);
     do {
-        u = rf_double_01(state) * 2.0 - 1.0;
-        s = u * u;
-    } while (s >= 1.0 || s == 0.0);
+        RANDOM__STAT(gaussian_candidates, 2);
+        u = random__to_double_01(random__next(s, scrambler)) * 2.0 - 1.0;
+        v = random__to_double_01(random__next(s, scrambler)) * 2.0 - 1.0;
+        r = u * u + v * v;
+    } while (r >= 1.0 || r == 0.0);
+
+    const double m = sqrt(-2.0 * log(r) / r);
+    out[0] = mu + sigma * (u * m);
+    out[1] = mu + sigma * (v * m);
+}
+
+static inline float random__float_gaussian_cached(uint64_t s[4], int scrambler, Random__GaussianCache *cache,
+                                                  float mu, float sigma) {
+    if (cache->has_spare) {
+        cache->has_spare = 0;
+        return mu + sigma * (float)cache->spare;
+    }
+
+    float pair[2];
+    random__float_gaussian_pair(s, scrambler, 0.0f, 1.0f, pair);
+    cache->spare = pair[1];
+    cache->has_spare = 1;
+    return mu + sigma * pair[0];
+}
+
+static inline double random__double_gaussian_cached(uint64_t s[4], int scrambler, Random__GaussianCache *cache,
+                                                    double mu, double sigma) {
+    if (cache->has_spare) {
+        cache->has_spare = 0;
+        return mu + sigma * cache->spare;
+    }
 
-    return mu + sigma * (u * sqrt(-0.5 * log(s) / s));
+    double pair[2];
+    random__double_gaussian_pair(s, scrambler, 0.0, 1.0, pair);
+    cache->spare = pair[1];
+    cache->has_spare = 1;
+    return mu + sigma * pair[0];
 }
 
+#elif RANDOM__CORE_VERSION != 1
+#error "random.h and random_float.h are from incompatible versions"
+#endif  //  RANDOM__CORE_INCLUDE
+
+typedef Random__State RFState;
+typedef Random__StateX4 RFStateX4;
+typedef Random__StateX8 RFStateX8;
+typedef Random__GaussianCache RFGaussianCache;
+
+// An RFState on its own cache line, for arrays of per-thread states. Pass
+// &aligned.state to the functions.
+typedef Random__StateAligned RFStateAligned;
+
+// States in structure-of-arrays layout, see Random__StateSoA
+typedef Random__StateSoA RFStateSoA;
+
+// Counters collected when RANDOM_STATS is defined
+typedef Random__Stats RFStats;
+
+RANDOM_HOST_DEVICE static inline void rf_seed(RFState *state, uint64_t seed) {
+    random__seed(state->s, seed);
+}
+
+RANDOM_HOST_DEVICE static inline uint64_t rf__next(RFState *state) {
+    return random__next(state->s, RANDOM__PLUS);
+}
+
+RANDOM_HOST_DEVICE static inline void rf_jump(RFState *state) {
+    random__jump(state->s);
+}
+
+RANDOM_HOST_DEVICE static inline void rf_long_jump(RFState *state) {
+    random__long_jump(state->s);
+}
+
+static inline void rf_seed_soa(RFStateSoA *soa, uint64_t seed) {
+    random__seed_soa(soa, seed);
+}
+
+RANDOM_HOST_DEVICE static inline void rf_load_soa(const RFStateSoA *soa, size_t i, RFState *state) {
+    random__load_soa(soa, i, state->s);
+}
+
+RANDOM_HOST_DEVICE static inline void rf_store_soa(RFStateSoA *soa, size_t i, const RFState *state) {
+    random__store_soa(soa, i, state->s);
+}
+
+static inline RFStateAligned *rf_alloc_states(size_t n, uint64_t seed) {
+    return random__alloc_states(n, seed);
+}
+
+static inline void rf_free_states(RFStateAligned *states) {
+    random__aligned_free(states);
+}
+
+static inline void rf_state_save(const RFState *state, unsigned char out[RANDOM_STATE_BYTES]) {
+    random__states_save(state->s, 1, sizeof(state->s), sizeof(uint64_t), out);
+}
+
+static inline int rf_state_load(RFState *state, const unsigned char in[RANDOM_STATE_BYTES]) {
+    return random__states_load(state->s, 1, sizeof(state->s), sizeof(uint64_t), in);
+}
+
+// stride is the distance between states in bytes, e.g. sizeof(RFStateAligned).
+// A smaller one would overlap the states, and one that isn't a multiple of 8
+// would misalign the words.
+static inline void rf_states_save(const void *states, size_t n, size_t stride, unsigned char *out) {
+    assert(stride >= sizeof(RFState) && stride % sizeof(uint64_t) == 0);
+    random__states_save(states, n, stride, sizeof(uint64_t), out);
+}
+
+static inline int rf_states_load(void *states, size_t n, size_t stride, const unsigned char *in) {
+    assert(stride >= sizeof(RFState) && stride % sizeof(uint64_t) == 0);
+    return random__states_load(states, n, stride, sizeof(uint64_t), in);
+}
+
+static inline void rf_state_save_x4(const RFStateX4 *state, unsigned char out[RANDOM_STATES_BYTES(4)]) {
+    random__states_save(state->s[0], 4, sizeof(uint64_t), sizeof(state->s[0]), out);
+}
+
+static inline int rf_state_load_x4(RFStateX4 *state, const unsigned char in[RANDOM_STATES_BYTES(4)]) {
+    return random__states_load(state->s[0], 4, sizeof(uint64_t), sizeof(state->s[0]), in);
+}
+
+static inline void rf_state_save_x8(const RFStateX8 *state, unsigned char out[RANDOM_STATES_BYTES(8)]) {
+    random__states_save(state->s[0], 8, sizeof(uint64_t), sizeof(state->s[0]), out);
+}
+
+static inline int rf_state_load_x8(RFStateX8 *state, const unsigned char in[RANDOM_STATES_BYTES(8)]) {
+    return random__states_load(state->s[0], 8, sizeof(uint64_t), sizeof(state->s[0]), in);
+}
+
+RANDOM_HOST_DEVICE static inline float rf_float_01(RFState *state) {
+    return random__to_float_01(rf__next(state));
+}
+
+// See random__to_float_01_fast and random__float_01_full
+RANDOM_HOST_DEVICE static inline float rf_float_01_fast(RFState *state) {
+    return random__to_float_01_fast(rf__next(state));
+}
+
+RANDOM_HOST_DEVICE static inline double rf_double_01_fast(RFState *state) {
+    return random__to_double_01_fast(rf__next(state));
+}
+
+static inline float rf_float_01_full(RFState *state) {
+    return random__float_01_full(state->s, RANDOM__PLUS);
+}
+
+static inline double rf_double_01_full(RFState *state) {
+    return random__double_01_full(state->s, RANDOM__PLUS);
+}
+
+RANDOM_HOST_DEVICE static inline void rf_float2_01(RFState *state, float out[2]) {
+    const uint64_t x = rf__next(state);
+    out[0] = random__to_float_01(x);
+    out[1] = random__to_float_01_low(x);
+}
+
+RANDOM_HOST_DEVICE static inline double rf_double_01(RFState *state) {
+    return random__to_double_01(rf__next(state));
+}
+
+static inline void rf_fill_float_01(RFState *state, float *out, size_t n) {
+    RFState s = *state;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const uint64_t x = rf__next(&s);
+        out[i] = random__to_float_01(x);
+        out[i + 1] = random__to_float_01_low(x);
+    }
+    if (i < n) {
+        out[i] = rf_float_01(&s);
+    }
+    *state = s;
+}
+
+static inline void rf_fill_double_01(RFState *state, double *out, size_t n) {
+    RFState s = *state;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = rf_double_01(&s);
+    }
+    *state = s;
+}
+
+RANDOM_HOST_DEVICE static inline float rf_float(RFState *state, float lower, float upper) {
+    return lower + (upper - lower) * rf_float_01(state);
+}
+
+RANDOM_HOST_DEVICE static inline double rf_double(RFState *state, double lower, double upper) {
+    return lower + (upper - lower) * rf_double_01(state);
+}
+
+static inline void rf_fill_float(RFState *state, float *out, size_t n, float lower, float upper) {
+    RFState s = *state;
+    const float scale = upper - lower;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        const uint64_t x = rf__next(&s);
+        out[i] = lower + scale * random__to_float_01(x);
+        out[i + 1] = lower + scale * random__to_float_01_low(x);
+    }
+    if (i < n) {
+        out[i] = rf_float(&s, lower, upper);
+    }
+    *state = s;
+}
+
+static inline void rf_fill_double(RFState *state, double *out, size_t n, double lower, double upper) {
+    RFState s = *state;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = rf_double(&s, lower, upper);
+    }
+    *state = s;
+}
+
+static inline float rf_float_gaussian(RFState *state, float mu, float sigma) {
+    return mu + sigma * random__float_normal(state->s, RANDOM__PLUS);
+}
+
+static inline double rf_double_gaussian(RFState *state, double mu, double sigma) {
+    return mu + sigma * random__double_normal(state->s, RANDOM__PLUS);
+}
+
+static inline void rf_fill_float_gaussian(RFState *state, float *out, size_t n, float mu, float sigma) {
+    random__fill_float_gaussian(state->s, RANDOM__PLUS, out, n, mu, sigma);
+}
+
+static inline void rf_fill_double_gaussian(RFState *state, double *out, size_t n, double mu, double sigma) {
+    random__fill_double_gaussian(state->s, RANDOM__PLUS, out, n, mu, sigma);
+}
+
+static inline void rf_float_gaussian_pair(RFState *state, float mu, float sigma, float out[2]) {
+    random__float_gaussian_pair(state->s, RANDOM__PLUS, mu, sigma, out);
+}
+
+static inline void rf_double_gaussian_pair(RFState *state, double mu, double sigma, double out[2]) {
+    random__double_gaussian_pair(state->s, RANDOM__PLUS, mu, sigma, out);
+}
+
+static inline float rf_float_gaussian_cached(RFState *state, RFGaussianCache *cache, float mu, float sigma) {
+    return random__float_gaussian_cached(state->s, RANDOM__PLUS, cache, mu, sigma);
+}
+
+static inline double rf_double_gaussian_cached(RFState *state, RFGaussianCache *cache, double mu, double sigma) {
+    return random__double_gaussian_cached(state->s, RANDOM__PLUS, cache, mu, sigma);
+}
+
+static inline void rf_seed_x4(RFStateX4 *state, uint64_t seed) {
+    random__seed_lanes(state->s[0], state->s[1], state->s[2], state->s[3], 4, seed);
+}
+
+static inline void rf_seed_x8(RFStateX8 *state, uint64_t seed) {
+    random__seed_lanes(state->s[0], state->s[1], state->s[2], state->s[3], 8, seed);
+}
+
+static inline void rf__next_x4(RFStateX4 *state, uint64_t out[4]) {
+    random__next_x4(state->s, out, RANDOM__PLUS);
+}
+
+static inline void rf__next_x8(RFStateX8 *state, uint64_t out[8]) {
+    random__next_x8(state->s, out, RANDOM__PLUS);
+}
+
+static inline void rf_fill_float_01_x4(RFStateX4 *state, float *out, size_t n) {
+    RFStateX4 s = *state;
+    uint64_t x[4];
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        rf__next_x4(&s, x);
+        for (size_t j = 0; j < 4; j++) {
+            out[i + 2 * j] = random__to_float_01(x[j]);
+            out[i + 2 * j + 1] = random__to_float_01_low(x[j]);
+        }
+    }
+    if (i < n) {
+        float tail[8];
+        rf__next_x4(&s, x);
+        for (size_t j = 0; j < 4; j++) {
+            tail[2 * j] = random__to_float_01(x[j]);
+            tail[2 * j + 1] = random__to_float_01_low(x[j]);
+        }
+        for (size_t j = 0; j < n - i; j++) {
+            out[i + j] = tail[j];
+        }
+    }
+    *state = s;
+}
+
+static inline void rf_fill_float_01_x8(RFStateX8 *state, float *out, size_t n) {
+    RFStateX8 s = *state;
+    uint64_t x[8];
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        rf__next_x8(&s, x);
+        for (size_t j = 0; j < 8; j++) {
+            out[i + 2 * j] = random__to_float_01(x[j]);
+            out[i + 2 * j + 1] = random__to_float_01_low(x[j]);
+        }
+    }
+    if (i < n) {
+        float tail[16];
+        rf__next_x8(&s, x);
+        for (size_t j = 0; j < 8; j++) {
+            tail[2 * j] = random__to_float_01(x[j]);
+            tail[2 * j + 1] = random__to_float_01_low(x[j]);
+        }
+        for (size_t j = 0; j < n - i; j++) {
+            out[i + j] = tail[j];
+        }
+    }
+    *state = s;
+}
+
+static inline void rf_fill_double_01_x4(RFStateX4 *state, double *out, size_t n) {
+    RFStateX4 s = *state;
+    uint64_t x[4];
+    for (size_t i = 0; i < n; i += 4) {
+        rf__next_x4(&s, x);
+        for (size_t j = 0; j < 4 && i + j < n; j++) {
+            out[i + j] = random__to_double_01(x[j]);
+        }
+    }
+    *state = s;
+}
+
+static inline void rf_fill_double_01_x8(RFStateX8 *state, double *out, size_t n) {
+    RFStateX8 s = *state;
+    uint64_t x[8];
+    for (size_t i = 0; i < n; i += 8) {
+        rf__next_x8(&s, x);
+        for (size_t j = 0; j < 8 && i + j < n; j++) {
+            out[i + j] = random__to_double_01(x[j]);
+        }
+    }
+    *state = s;
+}
+
+// Defined in the file that defines RANDOM_IMPLEMENTATION
+void rf_fill_float_01_x4_dispatch(RFStateX4 *state, float *out, size_t n);
+void rf_fill_float_01_x8_dispatch(RFStateX8 *state, float *out, size_t n);
+void rf_fill_double_01_x4_dispatch(RFStateX4 *state, double *out, size_t n);
+void rf_fill_double_01_x8_dispatch(RFStateX8 *state, double *out, size_t n);
+const char *rf_dispatch_target(void);
+
+#ifdef RANDOM_STATS
+void rf_stats_get(RFStats *stats);
+void rf_stats_reset(void);
+void rf_stats_dump(FILE *file, const RFStats *stats);
+#endif
+
 #ifdef __cplusplus
 }  //  extern "C"
 #endif
 
 #endif  //  RANDOM_FLOAT_H_INCLUDE
 
+// Implementation shared by random.h and random_float.h, compiled once in the
+// file that defines RANDOM_IMPLEMENTATION, whichever of the headers it includes
+#if defined(RANDOM_IMPLEMENTATION) && !defined(RANDOM__SHARED_IMPLEMENTATION)
+#define RANDOM__SHARED_IMPLEMENTATION
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef RANDOM__DISPATCH
+// Each kernel writes steps steps of every lane to out, in the same order as the
+// fill functions, with the outputs in native byte order. x86 is little endian,
+// so that is also the byte order of random_fill_bytes_x4 and _x8. The headers
+// wrap them for their own scrambler.
+typedef void (*Random__KernelX4)(Random__StateX4 *state, void *out, size_t steps);
+typedef void (*Random__KernelX8)(Random__StateX8 *state, void *out, size_t steps);
+
+static inline void random__kernel_x4_generic(Random__StateX4 *state, void *out, size_t steps, int scrambler) {
+    Random__StateX4 s = *state;
+    uint64_t x[4];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes(s.s[0], s.s[1], s.s[2], s.s[3], x, 4, scrambler);
+        memcpy((unsigned char *)out + 32 * i, x, 32);
+    }
+    *state = s;
+}
+
+static inline void random__kernel_x8_generic(Random__StateX8 *state, void *out, size_t steps, int scrambler) {
+    Random__StateX8 s = *state;
+    uint64_t x[8];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes(s.s[0], s.s[1], s.s[2], s.s[3], x, 8, scrambler);
+        memcpy((unsigned char *)out + 64 * i, x, 64);
+    }
+    *state = s;
+}
+
+RANDOM__TARGET_AVX2 static inline void random__kernel_x4_avx2(Random__StateX4 *state, void *out, size_t steps,
+                                                              int scrambler) {
+    Random__StateX4 s = *state;
+    uint64_t x[4];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes_avx2(s.s[0], s.s[1], s.s[2], s.s[3], x, scrambler);
+        memcpy((unsigned char *)out + 32 * i, x, 32);
+    }
+    *state = s;
+}
+
+RANDOM__TARGET_AVX2 static inline void random__kernel_x8_avx2(Random__StateX8 *state, void *out, size_t steps,
+                                                              int scrambler) {
+    Random__StateX8 s = *state;
+    uint64_t x[8];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes_avx2(s.s[0], s.s[1], s.s[2], s.s[3], x, scrambler);
+        random__next_lanes_avx2(s.s[0] + 4, s.s[1] + 4, s.s[2] + 4, s.s[3] + 4, x + 4, scrambler);
+        memcpy((unsigned char *)out + 64 * i, x, 64);
+    }
+    *state = s;
+}
+
+RANDOM__TARGET_AVX512 static inline void random__kernel_x8_avx512(Random__StateX8 *state, void *out, size_t steps,
+                                                                  int scrambler) {
+    Random__StateX8 s = *state;
+    uint64_t x[8];
+    for (size_t i = 0; i < steps; i++) {
+        random__next_lanes_avx512(s.s[0], s.s[1], s.s[2], s.s[3], x, scrambler);
+        memcpy((unsigned char *)out + 64 * i, x, 64);
+    }
+    *state = s;
+}
+
+// 2 with AVX-512F, 1 with only AVX2, 0 otherwise. Indexes random__cpu_names.
+static int random__cpu_level(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx512f") ? 2 : __builtin_cpu_supports("avx2") ? 1 : 0;
+}
+
+static const char *const random__cpu_names[3] = {"generic", "avx2", "avx512f"};
+#endif  //  RANDOM__DISPATCH
+
+#ifdef RANDOM_STATS
+RANDOM__THREAD_LOCAL Random__Stats random__stats;
+
+static double random__stats_ratio(uint64_t a, uint64_t b) {
+    return b ? (double)a / (double)b : 0.0;
+}
+
+// Prints the counters of the calling thread if stats is NULL
+static void random__stats_dump(FILE *file, const Random__Stats *stats) {
+    const Random__Stats s = stats ? *stats : random__stats;
+    fprintf(file, "steps: %llu\n", (unsigned long long)s.steps);
+    fprintf(file, "range: %llu samples, %.4f candidates and %.4f divisions per sample\n",
+            (unsigned long long)s.range_samples, random__stats_ratio(s.range_candidates, s.range_samples),
+            random__stats_ratio(s.range_divisions, s.range_samples));
+    fprintf(file, "gaussian: %llu samples, %.4f%% slow, %.4f candidates per sample\n",
+            (unsigned long long)s.gaussian_samples, 100.0 * random__stats_ratio(s.gaussian_slow, s.gaussian_samples),
+            random__stats_ratio(s.gaussian_candidates, s.gaussian_samples));
+}
+#endif  //  RANDOM_STATS
+
+#ifdef __cplusplus
+}  //  extern "C"
+#endif
+
+#endif  //  RANDOM__SHARED_IMPLEMENTATION
+
+#if defined(RANDOM_IMPLEMENTATION) && !defined(RANDOM_FLOAT_IMPLEMENTATION_INCLUDE)
+#define RANDOM_FLOAT_IMPLEMENTATION_INCLUDE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef RANDOM__DISPATCH
+static void rf__fill_x4_generic(RFStateX4 *state, void *out, size_t steps) {
+    random__kernel_x4_generic(state, out, steps, RANDOM__PLUS);
+}
+
+static void rf__fill_x8_generic(RFStateX8 *state, void *out, size_t steps) {
+    random__kernel_x8_generic(state, out, steps, RANDOM__PLUS);
+}
+
+RANDOM__TARGET_AVX2 static void rf__fill_x4_avx2(RFStateX4 *state, void *out, size_t steps) {
+    random__kernel_x4_avx2(state, out, steps, RANDOM__PLUS);
+}
+
+RANDOM__TARGET_AVX2 static void rf__fill_x8_avx2(RFStateX8 *state, void *out, size_t steps) {
+    random__kernel_x8_avx2(state, out, steps, RANDOM__PLUS);
+}
+
+RANDOM__TARGET_AVX512 static void rf__fill_x8_avx512(RFStateX8 *state, void *out, size_t steps) {
+    random__kernel_x8_avx512(state, out, steps, RANDOM__PLUS);
+}
+
+// Same as in random.h, the generic kernels work before rf__dispatch_init runs
+static Random__KernelX4 rf__fill_x4 = rf__fill_x4_generic;
+static Random__KernelX8 rf__fill_x8 = rf__fill_x8_generic;
+static int rf__dispatch_level;
+
+__attribute__((constructor)) static void rf__dispatch_init(void) {
+    rf__dispatch_level = random__cpu_level();
+    if (rf__dispatch_level >= 1) {
+        rf__fill_x4 = rf__fill_x4_avx2;
+        rf__fill_x8 = rf__fill_x8_avx2;
+    }
+    if (rf__dispatch_level >= 2) {
+        rf__fill_x8 = rf__fill_x8_avx512;
+    }
+}
+
+// The kernels write the raw outputs of up to this many values to a buffer on the
+// stack, which is then converted in place into out
+#define RF__DISPATCH_BLOCK 256
+
+static void rf__convert_float_01(const uint64_t *x, float *out, size_t n) {
+    for (size_t k = 0; k < n; k++) {
+        out[2 * k] = random__to_float_01(x[k]);
+        out[2 * k + 1] = random__to_float_01_low(x[k]);
+    }
+}
+
+static void rf__convert_double_01(const uint64_t *x, double *out, size_t n) {
+    for (size_t k = 0; k < n; k++) {
+        out[k] = random__to_double_01(x[k]);
+    }
+}
+#endif  //  RANDOM__DISPATCH
+
+// The remainder that doesn't fill a whole step goes through the inline
+// functions, which continue the same sequence
+void rf_fill_float_01_x4_dispatch(RFStateX4 *state, float *out, size_t n) {
+#ifdef RANDOM__DISPATCH
+    uint64_t x[RF__DISPATCH_BLOCK];
+    size_t i = 0;
+    while (n - i >= 8) {
+        const size_t left = (n - i) / 8;
+        const size_t steps = left < RF__DISPATCH_BLOCK / 4 ? left : RF__DISPATCH_BLOCK / 4;
+        RANDOM__STAT(steps, 4 * steps);
+        rf__fill_x4(state, x, steps);
+        rf__convert_float_01(x, out + i, 4 * steps);
+        i += 8 * steps;
+    }
+    rf_fill_float_01_x4(state, out + i, n - i);
+#else
+    rf_fill_float_01_x4(state, out, n);
+#endif
+}
+
+void rf_fill_float_01_x8_dispatch(RFStateX8 *state, float *out, size_t n) {
+#ifdef RANDOM__DISPATCH
+    uint64_t x[RF__DISPATCH_BLOCK];
+    size_t i = 0;
+    while (n - i >= 16) {
+        const size_t left = (n - i) / 16;
+        const size_t steps = left < RF__DISPATCH_BLOCK / 8 ? left : RF__DISPATCH_BLOCK / 8;
+        RANDOM__STAT(steps, 8 * steps);
+        rf__fill_x8(state, x, steps);
+        rf__convert_float_01(x, out + i, 8 * steps);
+        i += 16 * steps;
+    }
+    rf_fill_float_01_x8(state, out + i, n - i);
+#else
+    rf_fill_float_01_x8(state, out, n);
+#endif
+}
+
+void rf_fill_double_01_x4_dispatch(RFStateX4 *state, double *out, size_t n) {
+#ifdef RANDOM__DISPATCH
+    uint64_t x[RF__DISPATCH_BLOCK];
+    size_t i = 0;
+    while (n - i >= 4) {
+        const size_t left = (n - i) / 4;
+        const size_t steps = left < RF__DISPATCH_BLOCK / 4 ? left : RF__DISPATCH_BLOCK / 4;
+        RANDOM__STAT(steps, 4 * steps);
+        rf__fill_x4(state, x, steps);
+        rf__convert_double_01(x, out + i, 4 * steps);
+        i += 4 * steps;
+    }
+    rf_fill_double_01_x4(state, out + i, n - i);
+#else
+    rf_fill_double_01_x4(state, out, n);
+#endif
+}
+
+void rf_fill_double_01_x8_dispatch(RFStateX8 *state, double *out, size_t n) {
+#ifdef RANDOM__DISPATCH
+    uint64_t x[RF__DISPATCH_BLOCK];
+    size_t i = 0;
+    while (n - i >= 8) {
+        const size_t left = (n - i) / 8;
+        const size_t steps = left < RF__DISPATCH_BLOCK / 8 ? left : RF__DISPATCH_BLOCK / 8;
+        RANDOM__STAT(steps, 8 * steps);
+        rf__fill_x8(state, x, steps);
+        rf__convert_double_01(x, out + i, 8 * steps);
+        i += 8 * steps;
+    }
+    rf_fill_double_01_x8(state, out + i, n - i);
+#else
+    rf_fill_double_01_x8(state, out, n);
+#endif
+}
+
+// Names the instruction set used by the functions above, e.g. for logging
+const char *rf_dispatch_target(void) {
+#ifdef RANDOM__DISPATCH
+    return random__cpu_names[rf__dispatch_level];
+#elif defined(__AVX512F__)
+    return "avx512f";
+#elif defined(__AVX2__)
+    return "avx2";
+#else
+    return "generic";
+#endif
+}
+
+// The same counters as random_stats_get, random_stats_reset and random_stats_dump
+#ifdef RANDOM_STATS
+void rf_stats_get(RFStats *stats) {
+    *stats = random__stats;
+}
+
+void rf_stats_reset(void) {
+    memset(&random__stats, 0, sizeof(random__stats));
+}
+
+void rf_stats_dump(FILE *file, const RFStats *stats) {
+    random__stats_dump(file, stats);
+}
+#endif  //  RANDOM_STATS
+
+#ifdef __cplusplus
+}  //  extern "C"
+#endif
+
+#endif  //  RANDOM_IMPLEMENTATION
+
 /*
 To the extent possible under law, the author has dedicated all copyright and
 related and neighboring rights to this software to the public domain worldwide.
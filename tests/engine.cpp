@@ -0,0 +1,122 @@
+// Checks that rnd::engine from random.hpp gives the same sequences as the C
+// functions it wraps, both at run time and in constant expressions, where it
+// uses its own copies of them, and that it works with the standard library
+// algorithms and distributions.
+
+#include "random.hpp"
+#include "test.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define N 4099
+
+template <class Algo, class State>
+static void check_sequence(const char *name, uint64_t seed, void (*c_seed)(State *, uint64_t),
+                           uint64_t (*c_next)(State *)) {
+    rnd::engine<Algo> gen(seed);
+    State state;
+    c_seed(&state, seed);
+    size_t i = 0;
+    while (i < N && gen() == c_next(&state)) {
+        i++;
+    }
+    char detail[64];
+    snprintf(detail, sizeof(detail), i == N ? "%zu values match" : "value %zu differs", i);
+    test_check(i == N, name, detail);
+}
+
+template <class Algo>
+static void check_jumps(const char *name, void (*c_jump)(typename Algo::state_type *),
+                        void (*c_long_jump)(typename Algo::state_type *)) {
+    rnd::engine<Algo> gen(7);
+    typename Algo::state_type state = *gen.state();
+    gen.jump();
+    gen.long_jump();
+    c_jump(&state);
+    c_long_jump(&state);
+    const int ok = memcmp(gen.state(), &state, sizeof(state)) == 0;
+    test_check(ok, name, ok ? "same state as the C jumps" : "differs from the C jumps");
+}
+
+// Tables computed by the compiler, with the C++ copies of the generators
+static constexpr auto u64_table = rnd::make_table<64>(9);
+static constexpr auto float_table = rnd::make_table<64, float, rnd::xoshiro256p>(9);
+static constexpr auto double_table = rnd::make_table<64, double>(9);
+static_assert(u64_table.size() == 64 && u64_table[0] != u64_table[1], "make_table");
+
+static void check_tables() {
+    RandomState state;
+    RFState rf_state;
+    int ok = 1;
+    random_seed(&state, 9);
+    for (size_t i = 0; i < 64; i++) {
+        ok &= u64_table[i] == random_u64(&state);
+    }
+    test_check(ok, "make_table<64>", ok ? "same values as random_u64" : "differs from random_u64");
+
+    ok = 1;
+    rf_seed(&rf_state, 9);
+    for (size_t i = 0; i < 64; i++) {
+        ok &= float_table[i] == rf_float_01(&rf_state);
+    }
+    test_check(ok, "make_table<64, float, xoshiro256p>", ok ? "same values as rf_float_01" : "differs from rf_float_01");
+
+    ok = 1;
+    random_seed(&state, 9);
+    for (size_t i = 0; i < 64; i++) {
+        ok &= double_table[i] == random_double_01(&state);
+    }
+    test_check(ok, "make_table<64, double>", ok ? "same values as random_double_01" : "differs from random_double_01");
+
+    // The same engine at run time
+    rnd::engine<rnd::xoshiro256p> gen(9);
+    ok = 1;
+    for (size_t i = 0; i < 64; i++) {
+        ok &= gen.float_01() == float_table[i];
+    }
+    test_check(ok, "engine<xoshiro256p>::float_01", ok ? "same values as the table" : "differs from the table");
+}
+
+int main() {
+    check_sequence<rnd::xoshiro256pp, RandomState>("engine<xoshiro256pp>", 1, random_seed, random_u64);
+    check_sequence<rnd::xoshiro256p, RFState>("engine<xoshiro256p>", 1, rf_seed, rf__next);
+    check_jumps<rnd::xoshiro256pp>("engine<xoshiro256pp> jumps", random_jump, random_long_jump);
+    check_jumps<rnd::xoshiro256p>("engine<xoshiro256p> jumps", rf_jump, rf_long_jump);
+    check_tables();
+
+    // seed() starts the same sequence as the constructor
+    rnd::engine<rnd::xoshiro256pp> a(3);
+    rnd::engine<rnd::xoshiro256pp> b;
+    a();
+    a.seed(5);
+    b.seed(5);
+    test_check(a() == b(), "engine seed", "reseeding restarts the sequence");
+
+    // UniformRandomBitGenerator, used by std::shuffle and the distributions
+    static_assert(rnd::engine<rnd::xoshiro256pp>::min() == 0, "min");
+    static_assert(rnd::engine<rnd::xoshiro256pp>::max() == UINT64_MAX, "max");
+    std::vector<int> v(1000);
+    for (int i = 0; i < 1000; i++) {
+        v[i] = i;
+    }
+    std::shuffle(v.begin(), v.end(), a);
+    std::vector<int> sorted = v;
+    std::sort(sorted.begin(), sorted.end());
+    int permutation = 1;
+    for (int i = 0; i < 1000; i++) {
+        permutation &= sorted[i] == i;
+    }
+    test_check(permutation && v != sorted, "std::shuffle", "shuffles a permutation");
+
+    std::uniform_int_distribution<int> dice(1, 6);
+    int in_range = 1;
+    for (int i = 0; i < 1000; i++) {
+        const int d = dice(a);
+        in_range &= d >= 1 && d <= 6;
+    }
+    test_check(in_range, "std::uniform_int_distribution", "values in range");
+
+    return test_result();
+}
@@ -0,0 +1,155 @@
+// Distribution test for the Gaussian samplers of random.h and random_float.h:
+// the single value, fill, pair and cached functions, for float and double.
+// Each one draws N values with MU and SIGMA, which are standardized and then
+// checked with a Kolmogorov-Smirnov test against the normal distribution, the
+// first four moments, and the number of values beyond 3 and 4 sigma, which
+// only a small part of the KS statistic depends on.
+
+#include "random.h"
+#include "random_float.h"
+#include "test.h"
+
+#define N ((size_t)1 << 21)
+#define MU 1.0
+#define SIGMA 2.0
+
+// Every sampler is called through the adaptor for its signature, which turns
+// the function pointer in the table back into its real type. RFState and
+// RandomState are the same type, so the rf_ functions share the adaptors.
+typedef void (*Function)(void);
+typedef void (*Adaptor)(Function function, RandomState *state, double *out, size_t n);
+
+typedef float (*FloatSingle)(RandomState *state, float mu, float sigma);
+typedef double (*DoubleSingle)(RandomState *state, double mu, double sigma);
+typedef void (*FloatFill)(RandomState *state, float *out, size_t n, float mu, float sigma);
+typedef void (*DoubleFill)(RandomState *state, double *out, size_t n, double mu, double sigma);
+typedef void (*FloatPair)(RandomState *state, float mu, float sigma, float out[2]);
+typedef void (*DoublePair)(RandomState *state, double mu, double sigma, double out[2]);
+typedef float (*FloatCached)(RandomState *state, RandomGaussianCache *cache, float mu, float sigma);
+typedef double (*DoubleCached)(RandomState *state, RandomGaussianCache *cache, double mu, double sigma);
+
+// The fills are called with a mix of short and long lengths, so the ends of the
+// fast path blocks and the tails shorter than a block are both covered
+static const size_t chunks[] = {1, 7, 64, 255, 256, 4099};
+
+#define CHUNK_COUNT (sizeof(chunks) / sizeof(chunks[0]))
+
+static void float_single(Function function, RandomState *state, double *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ((FloatSingle)function)(state, (float)MU, (float)SIGMA);
+    }
+}
+
+static void double_single(Function function, RandomState *state, double *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ((DoubleSingle)function)(state, MU, SIGMA);
+    }
+}
+
+static void float_fill(Function function, RandomState *state, double *out, size_t n) {
+    float buffer[4099];
+    for (size_t i = 0, c = 0; i < n; c++) {
+        const size_t m = chunks[c % CHUNK_COUNT] < n - i ? chunks[c % CHUNK_COUNT] : n - i;
+        ((FloatFill)function)(state, buffer, m, (float)MU, (float)SIGMA);
+        for (size_t j = 0; j < m; j++) {
+            out[i + j] = buffer[j];
+        }
+        i += m;
+    }
+}
+
+static void double_fill(Function function, RandomState *state, double *out, size_t n) {
+    for (size_t i = 0, c = 0; i < n; c++) {
+        const size_t m = chunks[c % CHUNK_COUNT] < n - i ? chunks[c % CHUNK_COUNT] : n - i;
+        ((DoubleFill)function)(state, out + i, m, MU, SIGMA);
+        i += m;
+    }
+}
+
+static void float_pair(Function function, RandomState *state, double *out, size_t n) {
+    for (size_t i = 0; i < n; i += 2) {
+        float pair[2];
+        ((FloatPair)function)(state, (float)MU, (float)SIGMA, pair);
+        out[i] = pair[0];
+        out[i + 1] = pair[1];
+    }
+}
+
+static void double_pair(Function function, RandomState *state, double *out, size_t n) {
+    for (size_t i = 0; i < n; i += 2) {
+        ((DoublePair)function)(state, MU, SIGMA, out + i);
+    }
+}
+
+static void float_cached(Function function, RandomState *state, double *out, size_t n) {
+    RandomGaussianCache cache;
+    memset(&cache, 0, sizeof(cache));
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ((FloatCached)function)(state, &cache, (float)MU, (float)SIGMA);
+    }
+}
+
+static void double_cached(Function function, RandomState *state, double *out, size_t n) {
+    RandomGaussianCache cache;
+    memset(&cache, 0, sizeof(cache));
+    for (size_t i = 0; i < n; i++) {
+        out[i] = ((DoubleCached)function)(state, &cache, MU, SIGMA);
+    }
+}
+
+static const struct {
+    const char *name;
+    Adaptor adaptor;
+    Function function;
+} samplers[] = {
+    {"random_float_gaussian", float_single, (Function)random_float_gaussian},
+    {"random_double_gaussian", double_single, (Function)random_double_gaussian},
+    {"random_fill_float_gaussian", float_fill, (Function)random_fill_float_gaussian},
+    {"random_fill_double_gaussian", double_fill, (Function)random_fill_double_gaussian},
+    {"random_float_gaussian_pair", float_pair, (Function)random_float_gaussian_pair},
+    {"random_double_gaussian_pair", double_pair, (Function)random_double_gaussian_pair},
+    {"random_float_gaussian_cached", float_cached, (Function)random_float_gaussian_cached},
+    {"random_double_gaussian_cached", double_cached, (Function)random_double_gaussian_cached},
+    {"rf_float_gaussian", float_single, (Function)rf_float_gaussian},
+    {"rf_double_gaussian", double_single, (Function)rf_double_gaussian},
+    {"rf_fill_float_gaussian", float_fill, (Function)rf_fill_float_gaussian},
+    {"rf_fill_double_gaussian", double_fill, (Function)rf_fill_double_gaussian},
+    {"rf_float_gaussian_pair", float_pair, (Function)rf_float_gaussian_pair},
+    {"rf_double_gaussian_pair", double_pair, (Function)rf_double_gaussian_pair},
+    {"rf_float_gaussian_cached", float_cached, (Function)rf_float_gaussian_cached},
+    {"rf_double_gaussian_cached", double_cached, (Function)rf_double_gaussian_cached},
+};
+
+int main(void) {
+    double *x = (double *)malloc(N * sizeof(double));
+    if (!x) {
+        return EXIT_FAILURE;
+    }
+
+    for (size_t s = 0; s < sizeof(samplers) / sizeof(samplers[0]); s++) {
+        RandomState state;
+        random_seed(&state, 0x6a09e667f3bcc908 + s);
+        samplers[s].adaptor(samplers[s].function, &state, x, N);
+
+        size_t beyond3 = 0;
+        size_t beyond4 = 0;
+        for (size_t i = 0; i < N; i++) {
+            x[i] = (x[i] - MU) / SIGMA;
+            beyond3 += fabs(x[i]) > 3.0;
+            beyond4 += fabs(x[i]) > 4.0;
+        }
+
+        char name[96];
+        snprintf(name, sizeof(name), "%s moments", samplers[s].name);
+        test_moments(name, x, N, 0.0, 1.0, 0.0, 1);
+        snprintf(name, sizeof(name), "%s beyond 3 sigma", samplers[s].name);
+        test_count(name, beyond3, N, erfc(3.0 / sqrt(2.0)));
+        snprintf(name, sizeof(name), "%s beyond 4 sigma", samplers[s].name);
+        test_count(name, beyond4, N, erfc(4.0 / sqrt(2.0)));
+        snprintf(name, sizeof(name), "%s KS", samplers[s].name);
+        test_ks(name, x, N, test_normal_cdf);
+    }
+
+    free(x);
+    return test_result();
+}
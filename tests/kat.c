@@ -0,0 +1,621 @@
+// Known answer tests. The generators are compared with the reference
+// implementations by David Blackman and Sebastiano Vigna, copied below from
+//     https://prng.di.unimi.it/xoshiro256plusplus.c
+//     https://prng.di.unimi.it/xoshiro256plus.c
+//     https://prng.di.unimi.it/splitmix64.c
+// including their jump and long_jump polynomials, so the tables in the headers
+// are checked against an independent copy. Philox4x32-10 is checked with the
+// test vectors that ship with Random123 (kat_vectors). Every bulk, multi-lane
+// and _dispatch path has to match the reference sequence, since the headers
+// promise the same values as the single value functions. The state handling
+// (random_split, the structure-of-arrays states and saved states) is checked
+// against the reference as well.
+
+#define RANDOM_IMPLEMENTATION
+#include "random.h"
+#include "random_float.h"
+#include "test.h"
+
+#define N 4099
+
+// Reference implementation
+
+static uint64_t ref_s[4];
+
+static inline uint64_t ref_rotl(const uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static void ref_step(void) {
+    const uint64_t t = ref_s[1] << 17;
+    ref_s[2] ^= ref_s[0];
+    ref_s[3] ^= ref_s[1];
+    ref_s[1] ^= ref_s[2];
+    ref_s[0] ^= ref_s[3];
+    ref_s[2] ^= t;
+    ref_s[3] = ref_rotl(ref_s[3], 45);
+}
+
+static uint64_t ref_next_plus_plus(void) {
+    const uint64_t result = ref_rotl(ref_s[0] + ref_s[3], 23) + ref_s[0];
+    ref_step();
+    return result;
+}
+
+static uint64_t ref_next_plus(void) {
+    const uint64_t result = ref_s[0] + ref_s[3];
+    ref_step();
+    return result;
+}
+
+static void ref_jump_poly(const uint64_t poly[4]) {
+    uint64_t s0 = 0;
+    uint64_t s1 = 0;
+    uint64_t s2 = 0;
+    uint64_t s3 = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (poly[i] & UINT64_C(1) << b) {
+                s0 ^= ref_s[0];
+                s1 ^= ref_s[1];
+                s2 ^= ref_s[2];
+                s3 ^= ref_s[3];
+            }
+            ref_step();
+        }
+    }
+    ref_s[0] = s0;
+    ref_s[1] = s1;
+    ref_s[2] = s2;
+    ref_s[3] = s3;
+}
+
+static void ref_jump(void) {
+    static const uint64_t JUMP[] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+    ref_jump_poly(JUMP);
+}
+
+static void ref_long_jump(void) {
+    static const uint64_t LONG_JUMP[] = {0x76e15d3efefdcbbf, 0xc5004e441c522fb3, 0x77710069854ee241,
+                                         0x39109bb02acbe635};
+    ref_jump_poly(LONG_JUMP);
+}
+
+static uint64_t ref_splitmix_x;
+
+static uint64_t ref_splitmix_next(void) {
+    uint64_t z = (ref_splitmix_x += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    return z ^ (z >> 31);
+}
+
+// Seeds the reference state like random_seed: each word is the first SplitMix64
+// output for the previous word
+static void ref_seed(uint64_t seed) {
+    for (int i = 0; i < 4; i++) {
+        ref_splitmix_x = seed;
+        ref_s[i] = seed = ref_splitmix_next();
+    }
+}
+
+// Checks
+
+static int check_state(const char *name, const uint64_t s[4]) {
+    const int ok = memcmp(s, ref_s, sizeof(ref_s)) == 0;
+    return test_check(ok, name, ok ? "matches the reference state" : "differs from the reference state");
+}
+
+static int check_values(const char *name, const uint64_t *x, const uint64_t *expected, size_t n) {
+    size_t i = 0;
+    while (i < n && x[i] == expected[i]) {
+        i++;
+    }
+    char detail[96];
+    if (i == n) {
+        snprintf(detail, sizeof(detail), "%zu values match", n);
+    } else {
+        snprintf(detail, sizeof(detail), "value %zu is %016llx, expected %016llx", i, (unsigned long long)x[i],
+                 (unsigned long long)expected[i]);
+    }
+    return test_check(i == n, name, detail);
+}
+
+// The byte fills are little endian, so decode them instead of copying
+static void decode_bytes(const unsigned char *bytes, uint64_t *x, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        x[i] = 0;
+        for (int b = 7; b >= 0; b--) {
+            x[i] = x[i] << 8 | bytes[8 * i + (size_t)b];
+        }
+    }
+}
+
+static void test_splitmix(void) {
+    // The first outputs of the reference SplitMix64 seeded with 0
+    static const uint64_t expected[4] = {0xe220a8397b1dcdaf, 0x6e789e6aa1b965f4, 0x06c45d188009454f,
+                                         0xf88bb8a8724c81ec};
+    uint64_t x[4];
+    ref_splitmix_x = 0;
+    for (int i = 0; i < 4; i++) {
+        x[i] = ref_splitmix_next();
+    }
+    check_values("splitmix64 seed 0", x, expected, 4);
+
+    RandomState state;
+    random_seed(&state, 0);
+    check_values("random_seed word 0", state.s, expected, 1);
+    ref_seed(0x243f6a8885a308d3);
+    random_seed(&state, 0x243f6a8885a308d3);
+    check_state("random_seed", state.s);
+    rf_seed(&state, 0x243f6a8885a308d3);
+    check_state("rf_seed", state.s);
+}
+
+static void test_scalar(uint64_t *x, uint64_t *expected) {
+    // A state that is easy to follow by hand: the first ++ output is
+    // rotl(1 + 4, 23) + 1 and the first + output is 1 + 4
+    static const uint64_t simple[4] = {1, 2, 3, 4};
+    static const uint64_t simple_expected[2] = {0x2800001, 5};
+    RandomState state;
+    memcpy(state.s, simple, sizeof(simple));
+    x[0] = random_u64(&state);
+    check_values("random_u64 state 1 2 3 4", x, simple_expected, 1);
+    memcpy(state.s, simple, sizeof(simple));
+    x[0] = rf__next(&state);
+    check_values("rf__next state 1 2 3 4", x, simple_expected + 1, 1);
+
+    ref_seed(1);
+    for (size_t i = 0; i < N; i++) {
+        expected[i] = ref_next_plus_plus();
+    }
+
+    random_seed(&state, 1);
+    for (size_t i = 0; i < N; i++) {
+        x[i] = random_u64(&state);
+    }
+    check_values("random_u64", x, expected, N);
+    check_state("random_u64 state", state.s);
+
+    random_seed(&state, 1);
+    random_fill_u64(&state, x, N);
+    check_values("random_fill_u64", x, expected, N);
+    check_state("random_fill_u64 state", state.s);
+
+    unsigned char *bytes = (unsigned char *)malloc(8 * N);
+    random_seed(&state, 1);
+    random_fill_bytes(&state, bytes, 8 * N);
+    decode_bytes(bytes, x, N);
+    free(bytes);
+    check_values("random_fill_bytes", x, expected, N);
+
+    RandomBuffer buffer;
+    random_buffer_init(&buffer, 1);
+    for (size_t i = 0; i < N; i++) {
+        x[i] = random_buffer_u64(&buffer);
+    }
+    check_values("random_buffer_u64", x, expected, N);
+
+    ref_seed(1);
+    for (size_t i = 0; i < N; i++) {
+        expected[i] = ref_next_plus();
+    }
+    rf_seed(&state, 1);
+    for (size_t i = 0; i < N; i++) {
+        x[i] = rf__next(&state);
+    }
+    check_values("rf__next", x, expected, N);
+    check_state("rf__next state", state.s);
+}
+
+static void test_jumps(void) {
+    RandomState state;
+
+    ref_seed(2);
+    ref_jump();
+    random_seed(&state, 2);
+    random_jump(&state);
+    check_state("random_jump", state.s);
+    rf_seed(&state, 2);
+    rf_jump(&state);
+    check_state("rf_jump", state.s);
+
+    ref_seed(2);
+    ref_long_jump();
+    random_seed(&state, 2);
+    random_long_jump(&state);
+    check_state("random_long_jump", state.s);
+    rf_seed(&state, 2);
+    rf_long_jump(&state);
+    check_state("rf_long_jump", state.s);
+
+    // A jump after some steps, so the state isn't just a seed
+    ref_seed(3);
+    for (int i = 0; i < 1000; i++) {
+        ref_step();
+    }
+    ref_jump();
+    ref_long_jump();
+    random_seed(&state, 3);
+    for (int i = 0; i < 1000; i++) {
+        random_u64(&state);
+    }
+    random_jump(&state);
+    random_long_jump(&state);
+    check_state("random_jump and random_long_jump after 1000 steps", state.s);
+
+    // State i of an aligned array starts i jumps after the seed, on its own
+    // cache line
+    RandomStateAligned *states = random_alloc_states(4, 4);
+    const int aligned = (uintptr_t)states % RANDOM_CACHE_LINE == 0 && sizeof(*states) == RANDOM_CACHE_LINE;
+    test_check(aligned, "random_alloc_states alignment", aligned ? "one state per line" : "not aligned");
+    ref_seed(4);
+    for (size_t i = 0; i < 4; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "random_alloc_states state %zu", i);
+        check_state(name, states[i].state.s);
+        ref_jump();
+    }
+    random_free_states(states);
+}
+
+// Lane j of a multi-lane state is the reference sequence j jumps after the
+// seed, and the fills write one step of every lane at a time
+static void expected_lanes(uint64_t *expected, size_t lanes, int plus_plus) {
+    ref_seed(5);
+    for (size_t j = 0; j < lanes; j++) {
+        const uint64_t saved[4] = {ref_s[0], ref_s[1], ref_s[2], ref_s[3]};
+        for (size_t i = j; i < N; i += lanes) {
+            expected[i] = plus_plus ? ref_next_plus_plus() : ref_next_plus();
+        }
+        memcpy(ref_s, saved, sizeof(ref_s));
+        ref_jump();
+    }
+}
+
+#define CHECK_LANES(lanes, fill) \
+    do { \
+        RandomStateX##lanes state; \
+        random_seed_x##lanes(&state, 5); \
+        fill(&state, x, N - N % lanes); \
+        check_values(#fill, x, expected, N - N % lanes); \
+    } while (0)
+
+#define CHECK_LANE_BYTES(lanes, fill) \
+    do { \
+        RandomStateX##lanes state; \
+        random_seed_x##lanes(&state, 5); \
+        fill(&state, bytes, 8 * (N - N % lanes)); \
+        decode_bytes(bytes, x, N - N % lanes); \
+        check_values(#fill, x, expected, N - N % lanes); \
+    } while (0)
+
+static void test_lanes(uint64_t *x, uint64_t *expected) {
+    unsigned char *bytes = (unsigned char *)malloc(8 * N);
+
+    expected_lanes(expected, 4, 1);
+    CHECK_LANES(4, random_fill_u64_x4);
+    CHECK_LANES(4, random_fill_u64_x4_dispatch);
+    CHECK_LANE_BYTES(4, random_fill_bytes_x4);
+    CHECK_LANE_BYTES(4, random_fill_bytes_x4_dispatch);
+
+    expected_lanes(expected, 8, 1);
+    CHECK_LANES(8, random_fill_u64_x8);
+    CHECK_LANES(8, random_fill_u64_x8_dispatch);
+    CHECK_LANE_BYTES(8, random_fill_bytes_x8);
+    CHECK_LANE_BYTES(8, random_fill_bytes_x8_dispatch);
+
+    expected_lanes(expected, 4, 1);
+    RandomStateX4 random4;
+    random_seed_x4(&random4, 5);
+    for (size_t i = 0; i + 4 <= N; i += 4) {
+        random_u64_x4(&random4, x + i);
+    }
+    check_values("random_u64_x4", x, expected, N - N % 4);
+
+    expected_lanes(expected, 8, 1);
+    RandomStateX8 random8;
+    random_seed_x8(&random8, 5);
+    for (size_t i = 0; i + 8 <= N; i += 8) {
+        random_u64_x8(&random8, x + i);
+    }
+    check_values("random_u64_x8", x, expected, N - N % 8);
+
+    // The rf_ fills only give floats and doubles, so check the raw lanes
+    expected_lanes(expected, 4, 0);
+    RFStateX4 state4;
+    rf_seed_x4(&state4, 5);
+    for (size_t i = 0; i + 4 <= N; i += 4) {
+        rf__next_x4(&state4, x + i);
+    }
+    check_values("rf__next_x4", x, expected, N - N % 4);
+
+    expected_lanes(expected, 8, 0);
+    RFStateX8 state8;
+    rf_seed_x8(&state8, 5);
+    for (size_t i = 0; i + 8 <= N; i += 8) {
+        rf__next_x8(&state8, x + i);
+    }
+    check_values("rf__next_x8", x, expected, N - N % 8);
+
+    free(bytes);
+    printf("     (_dispatch functions use %s)\n", random_dispatch_target());
+}
+
+// The child of random_split is SplitMix64 applied to the next four outputs of
+// the parent, and the parent is left four steps further on
+static void test_split(void) {
+    uint64_t child[4];
+    ref_seed(6);
+    for (int i = 0; i < 4; i++) {
+        // Each word is the first SplitMix64 output for an output of the
+        // parent, the same way ref_seed chains them
+        ref_splitmix_x = ref_next_plus_plus();
+        child[i] = ref_splitmix_next();
+    }
+
+    RandomState parent;
+    RandomState state;
+    random_seed(&parent, 6);
+    random_split(&parent, &state);
+    check_state("random_split parent", parent.s);
+    check_values("random_split child", state.s, child, 4);
+}
+
+// States in structure-of-arrays layout start i jumps after the seed like the
+// aligned arrays, and a state stored back in the middle leaves the others alone
+static void test_soa(void) {
+    uint64_t words[4 * 5];
+    RandomStateSoA soa;
+    soa.s = words;
+    soa.n = 5;
+    random_seed_soa(&soa, 7);
+
+    RandomState state;
+    ref_seed(7);
+    for (size_t i = 0; i < 5; i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "random_seed_soa state %zu", i);
+        random_load_soa(&soa, i, &state);
+        check_state(name, state.s);
+        ref_jump();
+    }
+
+    uint64_t before[4 * 5];
+    memcpy(before, words, sizeof(words));
+    random_load_soa(&soa, 2, &state);
+    for (int i = 0; i < 100; i++) {
+        random_u64(&state);
+    }
+    random_store_soa(&soa, 2, &state);
+    RandomState loaded;
+    random_load_soa(&soa, 2, &loaded);
+    int others = 1;
+    for (size_t w = 0; w < 4 * 5; w++) {
+        others &= w % 5 == 2 || words[w] == before[w];
+    }
+    test_check(memcmp(loaded.s, state.s, sizeof(state.s)) == 0 && others, "random_store_soa",
+               others ? "round trip" : "changed another state");
+}
+
+static int same_states(const RandomState *a, const RandomState *b) {
+    return memcmp(a->s, b->s, sizeof(a->s)) == 0;
+}
+
+// Saved states are the tag followed by the words in little endian order. A
+// load restores exactly what was saved, and refuses a wrong tag or an all zero
+// state without touching the states.
+static void test_save(void) {
+    static const unsigned char tag[8] = {'x', 'o', '2', '5', '6', 0, 0, 1};
+    unsigned char bytes[RANDOM_STATES_BYTES(8)];
+    uint64_t words[4 * 8];
+
+    RandomState state;
+    RandomState loaded;
+    random_seed(&state, 8);
+    random_state_save(&state, bytes);
+    decode_bytes(bytes + 8, words, 4);
+    test_check(memcmp(bytes, tag, 8) == 0, "random_state_save tag", "xo256 version 1");
+    check_values("random_state_save words", words, state.s, 4);
+    random_seed(&loaded, 9);
+    test_check(random_state_load(&loaded, bytes) == 0 && same_states(&loaded, &state), "random_state_load",
+               "round trip");
+    rf_state_save(&state, bytes);
+    random_seed(&loaded, 9);
+    test_check(rf_state_load(&loaded, bytes) == 0 && same_states(&loaded, &state), "rf_state_load", "round trip");
+
+    RandomState kept = loaded;
+    bytes[7] ^= 1;
+    test_check(random_state_load(&loaded, bytes) == -1 && same_states(&loaded, &kept), "random_state_load bad tag",
+               "rejected");
+    bytes[7] ^= 1;
+    memset(bytes + 8, 0, 32);
+    test_check(random_state_load(&loaded, bytes) == -1 && same_states(&loaded, &kept), "random_state_load zero state",
+               "rejected");
+
+    // Arrays with and without padding, and a zero state in the middle of one
+    RandomStateAligned *aligned = random_alloc_states(5, 10);
+    RandomStateAligned *restored = random_alloc_states(5, 11);
+    RandomState packed[5];
+    random_states_save(aligned, 5, sizeof(RandomStateAligned), bytes);
+    int ok = random_states_load(packed, 5, sizeof(RandomState), bytes) == 0;
+    ok &= random_states_load(restored, 5, sizeof(RandomStateAligned), bytes) == 0;
+    for (size_t i = 0; i < 5; i++) {
+        ok &= same_states(&packed[i], &aligned[i].state) && same_states(&restored[i].state, &aligned[i].state);
+    }
+    test_check(ok, "random_states_load", "round trip between aligned and packed arrays");
+    rf_states_save(packed, 5, sizeof(RandomState), bytes);
+    random_seed(&restored[4].state, 12);
+    ok = rf_states_load(restored, 5, sizeof(RFStateAligned), bytes) == 0;
+    test_check(ok && same_states(&restored[4].state, &packed[4]), "rf_states_load", "round trip");
+    memset(bytes + 8 + 32 * 3, 0, 32);
+    random_seed(&restored[0].state, 13);
+    kept = restored[0].state;
+    ok = random_states_load(restored, 5, sizeof(RandomStateAligned), bytes) == -1;
+    test_check(ok && same_states(&restored[0].state, &kept), "random_states_load zero state", "rejected");
+    random_free_states(aligned);
+    random_free_states(restored);
+
+    // A multi-lane state is saved as one state per lane
+    RandomStateX4 x4;
+    RandomStateX4 x4_loaded;
+    random_seed_x4(&x4, 14);
+    random_state_save_x4(&x4, bytes);
+    random_seed_x4(&x4_loaded, 15);
+    ok = random_state_load_x4(&x4_loaded, bytes) == 0 && memcmp(&x4_loaded, &x4, sizeof(x4)) == 0;
+    ok &= random_states_load(packed, 4, sizeof(RandomState), bytes) == 0;
+    for (size_t lane = 0; lane < 4; lane++) {
+        for (size_t i = 0; i < 4; i++) {
+            ok &= packed[lane].s[i] == x4.s[i][lane];
+        }
+    }
+    test_check(ok, "random_state_load_x4", "round trip, one state per lane");
+
+    RandomStateX8 x8;
+    RandomStateX8 x8_loaded;
+    random_seed_x8(&x8, 16);
+    random_state_save_x8(&x8, bytes);
+    random_seed_x8(&x8_loaded, 17);
+    ok = random_state_load_x8(&x8_loaded, bytes) == 0 && memcmp(&x8_loaded, &x8, sizeof(x8)) == 0;
+    decode_bytes(bytes + 8, words, 4 * 8);
+    for (size_t lane = 0; lane < 8; lane++) {
+        for (size_t i = 0; i < 4; i++) {
+            ok &= words[4 * lane + i] == x8.s[i][lane];
+        }
+    }
+    test_check(ok, "random_state_load_x8", "round trip, one state per lane");
+}
+
+// The buffer draws from the same stream as a state seeded the same way, so its
+// ranges and floats match the state functions
+static void test_buffer(uint64_t *x, uint64_t *expected) {
+    static const uint64_t ranges[3] = {1000, (uint64_t)1 << 32, ((uint64_t)1 << 63) + 1};
+    static RandomBuffer buffer;
+    RandomState state;
+    for (int r = 0; r < 3; r++) {
+        random_buffer_init(&buffer, 18);
+        random_seed(&state, 18);
+        for (size_t i = 0; i < N; i++) {
+            x[i] = random_buffer_range(&buffer, ranges[r]);
+            expected[i] = random_range(&state, ranges[r]);
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "random_buffer_range %llu", (unsigned long long)ranges[r]);
+        check_values(name, x, expected, N);
+    }
+
+    random_buffer_init(&buffer, 19);
+    random_seed(&state, 19);
+    int same = 1;
+    for (size_t i = 0; i < N; i++) {
+        same &= random_buffer_float_01(&buffer) == random_float_01(&state);
+        same &= random_buffer_double_01(&buffer) == random_double_01(&state);
+    }
+    test_check(same, "random_buffer_float_01 and random_buffer_double_01", same ? "match the state" : "differ");
+}
+
+// random_fill_alias draws its outputs in blocks, but has to give the same
+// indices and leave the same state as a loop over random_alias_sample
+static void test_alias(uint64_t *x, uint64_t *expected) {
+    double weights[1000];
+    for (int i = 0; i < 1000; i++) {
+        weights[i] = 1.0 + i % 7;
+    }
+    RandomAliasTable table;
+    if (!test_check(random_alias_init(&table, weights, 1000) == 0, "random_fill_alias", "random_alias_init")) {
+        return;
+    }
+
+    uint32_t *indices = (uint32_t *)malloc(N * sizeof(uint32_t));
+    static const size_t lengths[4] = {1, 255, 257, N};
+    for (int l = 0; l < 4; l++) {
+        const size_t n = lengths[l];
+        RandomState state;
+        random_seed(&state, 1);
+        for (size_t i = 0; i < n; i++) {
+            expected[i] = random_alias_sample(&state, &table);
+        }
+        memcpy(ref_s, state.s, sizeof(ref_s));
+
+        random_seed(&state, 1);
+        random_fill_alias(&state, &table, indices, n);
+        for (size_t i = 0; i < n; i++) {
+            x[i] = indices[i];
+        }
+        char name[64];
+        snprintf(name, sizeof(name), "random_fill_alias %zu", n);
+        check_values(name, x, expected, n);
+        snprintf(name, sizeof(name), "random_fill_alias %zu state", n);
+        check_state(name, state.s);
+    }
+    free(indices);
+    random_alias_free(&table);
+}
+
+static void test_philox(void) {
+    // Random123 kat_vectors for philox4x32 with 10 rounds: counter, key and
+    // the expected output
+    static const uint32_t vectors[3][10] = {
+        {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+         0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+        {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+         0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+        {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0,
+         0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1},
+    };
+    for (int v = 0; v < 3; v++) {
+        uint32_t out[4];
+        random__philox4x32(vectors[v], vectors[v] + 4, out);
+        const int ok = memcmp(out, vectors[v] + 6, sizeof(out)) == 0;
+        char name[64];
+        snprintf(name, sizeof(name), "philox4x32-10 vector %d", v);
+        test_check(ok, name, ok ? "matches Random123" : "differs from Random123");
+    }
+
+    // random_at(key, c) is half of the Philox block c / 2 with the key split
+    // into two words and the block number in the low counter words
+    const uint64_t key = 0x299f31d0a4093822;
+    uint64_t at[2];
+    at[0] = random_at(key, 0x05a308d3243f6a88 * 2);
+    at[1] = random_at(key, 0x05a308d3243f6a88 * 2 + 1);
+    const uint32_t counter[4] = {0x243f6a88, 0x05a308d3, 0, 0};
+    const uint32_t k[2] = {0xa4093822, 0x299f31d0};
+    uint32_t out[4];
+    random__philox4x32(counter, k, out);
+    const uint64_t expected[2] = {out[0] | (uint64_t)out[1] << 32, out[2] | (uint64_t)out[3] << 32};
+    check_values("random_at block layout", at, expected, 2);
+
+    // random_fill_at from odd and even starting points
+    uint64_t fill[37];
+    uint64_t single[37];
+    for (uint64_t start = 0x7ffffffffffffff0; start < 0x7ffffffffffffff2; start++) {
+        random_fill_at(key, start, fill, 37);
+        for (size_t i = 0; i < 37; i++) {
+            single[i] = random_at(key, start + i);
+        }
+        check_values(start & 1 ? "random_fill_at odd start" : "random_fill_at even start", fill, single, 37);
+    }
+}
+
+int main(void) {
+    uint64_t *x = (uint64_t *)malloc(N * sizeof(uint64_t));
+    uint64_t *expected = (uint64_t *)malloc(N * sizeof(uint64_t));
+    if (!x || !expected) {
+        return EXIT_FAILURE;
+    }
+
+    test_splitmix();
+    test_scalar(x, expected);
+    test_jumps();
+    test_split();
+    test_soa();
+    test_save();
+    test_lanes(x, expected);
+    test_buffer(x, expected);
+    test_alias(x, expected);
+    test_philox();
+
+    free(x);
+    free(expected);
+    return test_result();
+}
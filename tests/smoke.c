@@ -0,0 +1,766 @@
+// Fast statistical smoke battery for the samplers of random.h and
+// random_float.h, meant to catch a broken distribution in seconds, long before
+// a PractRand run (see stdin64.c) would. It runs chi-square tests on the range,
+// alias, Poisson and binomial samplers, the shuffles and subsets, random_bits
+// and the Bernoulli trials, and Kolmogorov-Smirnov tests and moments on the
+// exponential and uniform float samplers, each for the single value and the
+// fill functions. The Gaussian samplers are covered by gaussian.c.
+
+#define RANDOM_IMPLEMENTATION
+#include "random.h"
+#include "random_float.h"
+#include "test.h"
+
+#define N ((size_t)1 << 20)
+
+// At most this many bins per chi-square test, larger ranges are bucketed
+#define BINS 1024
+
+static uint64_t seed = 0xbb67ae8584caa73b;
+
+static void next_state(RandomState *state) {
+    random_seed(state, seed++);
+}
+
+// Integer ranges
+
+typedef void (*RangeSampler)(RandomState *state, uint64_t *out, size_t n, uint64_t range);
+
+static void range_single(RandomState *state, uint64_t *out, size_t n, uint64_t range) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random_range(state, range);
+    }
+}
+
+static void range_fill(RandomState *state, uint64_t *out, size_t n, uint64_t range) {
+    random_fill_range(state, out, n, range);
+}
+
+static void range_u32_single(RandomState *state, uint64_t *out, size_t n, uint64_t range) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random_range_u32(state, (uint32_t)range);
+    }
+}
+
+static void range_u32_fill(RandomState *state, uint64_t *out, size_t n, uint64_t range) {
+    uint32_t buffer[1000];
+    for (size_t i = 0; i < n; i += 1000) {
+        const size_t m = n - i < 1000 ? n - i : 1000;
+        random_fill_range_u32(state, buffer, m, (uint32_t)range);
+        for (size_t j = 0; j < m; j++) {
+            out[i + j] = buffer[j];
+        }
+    }
+}
+
+// random_int as a range from lower, so it fits the others
+static void int_single(RandomState *state, uint64_t *out, size_t n, uint64_t range) {
+    const int lower = -(int)(range / 2);
+    const int upper = (int)((int64_t)lower + (int64_t)range - 1);
+    for (size_t i = 0; i < n; i++) {
+        out[i] = (uint64_t)((int64_t)random_int(state, lower, upper) - lower);
+    }
+}
+
+// A buffer seeded from the state, so every range gets a fresh stream
+static void buffer_range(RandomState *state, uint64_t *out, size_t n, uint64_t range) {
+    static RandomBuffer buffer;
+    random_buffer_init(&buffer, random_u64(state));
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random_buffer_range(&buffer, range);
+    }
+}
+
+static void check_range(const char *name, RangeSampler sample, uint64_t range, uint64_t *x) {
+    static size_t counts[BINS];
+    static double probs[BINS];
+    const uint64_t width = range <= BINS ? 1 : range / BINS + (range % BINS != 0);
+    const size_t bins = (size_t)((range - 1) / width + 1);
+
+    RandomState state;
+    next_state(&state);
+    sample(&state, x, N, range);
+
+    size_t outside = 0;
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < N; i++) {
+        if (x[i] < range) {
+            counts[x[i] / width]++;
+        } else {
+            outside++;
+        }
+    }
+    for (size_t b = 0; b < bins; b++) {
+        const uint64_t end = b == bins - 1 ? range : (b + 1) * width;
+        probs[b] = (double)(end - b * width);
+    }
+
+    char full[96];
+    snprintf(full, sizeof(full), "%s range %llu", name, (unsigned long long)range);
+    if (test_check(outside == 0, full, outside ? "values out of range" : "all values in range")) {
+        test_chi2(full, counts, probs, bins);
+    }
+}
+
+static void test_ranges(uint64_t *x) {
+    // Small, just over and under powers of two, and huge ranges where close to
+    // half of the 64 bit candidates are rejected
+    static const uint64_t ranges[] = {
+        1, 2, 3, 7, 10, 1000, 1025, 65535, 65537, (1u << 31) + 1, 0xffffffff,
+        0x100000001, (uint64_t)1 << 63, ((uint64_t)1 << 63) + 1, 0xaaaaaaaaaaaaaaab, UINT64_MAX,
+    };
+    for (size_t i = 0; i < sizeof(ranges) / sizeof(ranges[0]); i++) {
+        check_range("random_range", range_single, ranges[i], x);
+        check_range("random_fill_range", range_fill, ranges[i], x);
+        check_range("random_buffer_range", buffer_range, ranges[i], x);
+        if (ranges[i] <= 0xffffffff) {
+            check_range("random_range_u32", range_u32_single, ranges[i], x);
+            check_range("random_fill_range_u32", range_u32_fill, ranges[i], x);
+        }
+        if (ranges[i] <= 0xffffffff && ranges[i] != 0xffffffff) {
+            check_range("random_int", int_single, ranges[i], x);
+        }
+    }
+}
+
+// Alias tables
+
+static void check_alias(const char *name, const double *weights, size_t n, int fill, uint64_t *x) {
+    RandomAliasTable table;
+    if (!test_check(random_alias_init(&table, weights, n) == 0, name, "random_alias_init")) {
+        return;
+    }
+
+    RandomState state;
+    next_state(&state);
+    uint32_t *samples = (uint32_t *)x;
+    if (fill) {
+        random_fill_alias(&state, &table, samples, N);
+    } else {
+        for (size_t i = 0; i < N; i++) {
+            samples[i] = random_alias_sample(&state, &table);
+        }
+    }
+
+    size_t *counts = (size_t *)calloc(n, sizeof(size_t));
+    size_t outside = 0;
+    size_t zero_weight = 0;
+    for (size_t i = 0; i < N; i++) {
+        if (samples[i] >= n) {
+            outside++;
+        } else {
+            counts[samples[i]]++;
+            zero_weight += weights[samples[i]] == 0.0;
+        }
+    }
+    if (test_check(outside == 0 && zero_weight == 0, name,
+                   outside ? "values out of range" : zero_weight ? "sampled a zero weight" : "support")) {
+        test_chi2(name, counts, weights, n);
+    }
+    free(counts);
+    random_alias_free(&table);
+}
+
+static void test_alias(uint64_t *x) {
+    static const double few[] = {1.0, 2.0, 3.0, 0.0, 4.0, 0.5, 0.0, 1e-3};
+    static double many[1000];
+    for (size_t i = 0; i < 1000; i++) {
+        // Weights over four orders of magnitude, with every tenth one zero
+        many[i] = i % 10 == 3 ? 0.0 : pow(10.0, (double)(i % 37) / 9.0);
+    }
+
+    check_alias("random_alias_sample 8 weights", few, 8, 0, x);
+    check_alias("random_fill_alias 8 weights", few, 8, 1, x);
+    check_alias("random_alias_sample 1000 weights", many, 1000, 0, x);
+    check_alias("random_fill_alias 1000 weights", many, 1000, 1, x);
+}
+
+// Permutations and subsets
+
+// Larger than the 64 byte buffer random_shuffle swaps elements through, so
+// every swap takes two chunks
+typedef struct {
+    uint32_t value;
+    unsigned char pad[68];
+} Wide;
+
+#define SHUFFLE_MAX 100
+
+// Shuffles the identity permutation of n elements with one of the shuffle
+// functions, and returns it in perm
+static void shuffle_with(int kind, RandomState *state, uint32_t *perm, size_t n) {
+    static uint64_t u64[SHUFFLE_MAX];
+    static Wide wide[SHUFFLE_MAX];
+    static void *ptr[SHUFFLE_MAX];
+    for (size_t i = 0; i < n; i++) {
+        perm[i] = (uint32_t)i;
+        u64[i] = i;
+        wide[i].value = (uint32_t)i;
+        ptr[i] = &wide[i];
+    }
+
+    if (kind == 0) {
+        random_shuffle(state, wide, n, sizeof(Wide));
+    } else if (kind == 1) {
+        random_shuffle_u32(state, perm, n);
+    } else if (kind == 2) {
+        random_shuffle_u64(state, u64, n);
+    } else {
+        random_shuffle_ptr(state, ptr, n);
+    }
+    for (size_t i = 0; i < n && kind != 1; i++) {
+        perm[i] = kind == 0 ? wide[i].value : kind == 2 ? (uint32_t)u64[i] : ((const Wide *)ptr[i])->value;
+    }
+}
+
+// Rank of a permutation of 0 <= x < n in 0 <= r < n!, or SIZE_MAX if it isn't
+// one
+static size_t permutation_rank(const uint32_t *perm, size_t n) {
+    unsigned seen = 0;
+    size_t rank = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (perm[i] >= n || (seen >> perm[i] & 1)) {
+            return SIZE_MAX;
+        }
+        // Lehmer code: the number of unused values smaller than perm[i]
+        size_t smaller = 0;
+        for (uint32_t v = 0; v < perm[i]; v++) {
+            smaller += !(seen >> v & 1);
+        }
+        seen |= 1u << perm[i];
+        rank = rank * (n - i) + smaller;
+    }
+    return rank;
+}
+
+static void test_shuffle(void) {
+    static const char *const names[4] = {"random_shuffle", "random_shuffle_u32", "random_shuffle_u64",
+                                         "random_shuffle_ptr"};
+    static size_t counts[SHUFFLE_MAX];
+    static double probs[120];
+    uint32_t perm[SHUFFLE_MAX];
+    for (int kind = 0; kind < 4; kind++) {
+        // All 120 permutations of 5 elements are equally likely
+        RandomState state;
+        next_state(&state);
+        size_t invalid = 0;
+        size_t ranks[120] = {0};
+        for (size_t t = 0; t < N / 8; t++) {
+            shuffle_with(kind, &state, perm, 5);
+            const size_t r = permutation_rank(perm, 5);
+            if (r == SIZE_MAX) {
+                invalid++;
+            } else {
+                ranks[r]++;
+            }
+        }
+        for (size_t r = 0; r < 120; r++) {
+            probs[r] = 1.0;
+        }
+        char name[96];
+        snprintf(name, sizeof(name), "%s 5 elements", names[kind]);
+        if (test_check(invalid == 0, name, invalid ? "not a permutation" : "permutations")) {
+            test_chi2(name, ranks, probs, 120);
+        }
+
+        // With 100 elements the swaps span several batches. The first and the
+        // last element end up at every position with the same probability.
+        size_t last[SHUFFLE_MAX];
+        memset(counts, 0, sizeof(counts));
+        memset(last, 0, sizeof(last));
+        for (size_t t = 0; t < N / 64; t++) {
+            shuffle_with(kind, &state, perm, SHUFFLE_MAX);
+            for (size_t i = 0; i < SHUFFLE_MAX; i++) {
+                counts[i] += perm[i] == 0;
+                last[i] += perm[i] == SHUFFLE_MAX - 1;
+            }
+        }
+        for (size_t i = 0; i < SHUFFLE_MAX; i++) {
+            probs[i] = 1.0;
+        }
+        snprintf(name, sizeof(name), "%s 100 elements, first element", names[kind]);
+        test_chi2(name, counts, probs, SHUFFLE_MAX);
+        snprintf(name, sizeof(name), "%s 100 elements, last element", names[kind]);
+        test_chi2(name, last, probs, SHUFFLE_MAX);
+    }
+}
+
+// Returns the indices as a bit mask, or 0 if they aren't distinct or in range
+static uint64_t index_mask(const size_t *idx, size_t k, size_t n) {
+    uint64_t mask = 0;
+    for (size_t i = 0; i < k; i++) {
+        if (idx[i] >= n || (mask >> idx[i] & 1)) {
+            return 0;
+        }
+        mask |= (uint64_t)1 << idx[i];
+    }
+    return mask;
+}
+
+static int popcount(uint64_t x) {
+    int count = 0;
+    for (; x; x &= x - 1) {
+        count++;
+    }
+    return count;
+}
+
+// Every subset of k of 10 indices is equally likely, so the subsets are
+// counted by their bit mask, where the masks with other than k bits have
+// probability 0
+static void check_subsets(const char *name, size_t k, const size_t *subsets, size_t invalid) {
+    static double probs[1024];
+    for (size_t m = 0; m < 1024; m++) {
+        probs[m] = popcount(m) == (int)k ? 1.0 : 0.0;
+    }
+    if (test_check(invalid == 0, name, invalid ? "repeated or out of range indices" : "distinct indices")) {
+        test_chi2(name, subsets, probs, 1024);
+    }
+}
+
+static void test_subsets(void) {
+    static size_t subsets[1024];
+    size_t idx[64];
+    for (size_t k = 1; k <= 9; k += 4) {
+        RandomState state;
+        next_state(&state);
+        size_t invalid = 0;
+        memset(subsets, 0, sizeof(subsets));
+        for (size_t t = 0; t < N / 8; t++) {
+            random_sample_indices(&state, idx, k, 10);
+            const uint64_t mask = index_mask(idx, k, 10);
+            invalid += mask == 0;
+            subsets[mask]++;
+        }
+        char name[96];
+        snprintf(name, sizeof(name), "random_sample_indices %zu of 10", k);
+        check_subsets(name, k, subsets, invalid);
+    }
+
+    // All indices, and a few out of a range above 32 bits, where the draws
+    // switch to random_range
+    RandomState state;
+    next_state(&state);
+    size_t invalid = 0;
+    for (size_t t = 0; t < 1000; t++) {
+        random_sample_indices(&state, idx, 64, 64);
+        invalid += index_mask(idx, 64, 64) != ~(uint64_t)0;
+    }
+    test_check(invalid == 0, "random_sample_indices 64 of 64", invalid ? "not a permutation" : "every index once");
+    const uint64_t huge = (uint64_t)1 << 40;
+    invalid = 0;
+    for (size_t t = 0; t < 1000; t++) {
+        random_sample_indices(&state, idx, 8, (size_t)huge);
+        for (size_t i = 0; i < 8; i++) {
+            int repeated = 0;
+            for (size_t j = 0; j < i; j++) {
+                repeated |= idx[i] == idx[j];
+            }
+            invalid += repeated || idx[i] >= huge;
+        }
+    }
+    test_check(invalid == 0, "random_sample_indices 8 of 2^40",
+               invalid ? "repeated or out of range indices" : "distinct indices");
+
+    // A reservoir of 3 items from a stream of 10 keeps every subset with the
+    // same probability
+    memset(subsets, 0, sizeof(subsets));
+    invalid = 0;
+    for (size_t t = 0; t < N / 8; t++) {
+        for (size_t i = 0; i < 10; i++) {
+            const size_t slot = random_reservoir_slot(&state, i, 3);
+            if (slot < 3) {
+                idx[slot] = i;
+            } else if (slot != 3) {
+                invalid++;
+            }
+        }
+        const uint64_t mask = index_mask(idx, 3, 10);
+        invalid += mask == 0;
+        subsets[mask]++;
+    }
+    check_subsets("random_reservoir_slot 3 of 10", 3, subsets, invalid);
+}
+
+// Bits and Bernoulli trials
+
+static void test_bits(void) {
+    static size_t counts[BINS];
+    static double probs[BINS];
+    static const unsigned ks[] = {1, 3, 7, 10, 13, 32};
+    for (size_t j = 0; j < sizeof(ks) / sizeof(ks[0]); j++) {
+        // k bits give 2^k equally likely values, bucketed by their top bits
+        const unsigned k = ks[j];
+        const unsigned shift = k > 10 ? k - 10 : 0;
+        const size_t bins = (size_t)1 << (k - shift);
+        RandomState state;
+        next_state(&state);
+        RandomBits reservoir = {0, 0};
+        memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < N; i++) {
+            counts[random_bits(&state, &reservoir, k) >> shift]++;
+        }
+        for (size_t b = 0; b < bins; b++) {
+            probs[b] = 1.0;
+        }
+        char name[96];
+        snprintf(name, sizeof(name), "random_bits %u", k);
+        test_chi2(name, counts, probs, bins);
+    }
+
+    // Consecutive values share outputs, so pairs of them have to be
+    // independent too, including across refills, which 5 bits at a time cross
+    // in the middle of every 13th pair
+    RandomState state;
+    next_state(&state);
+    RandomBits reservoir = {0, 0};
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < N; i++) {
+        const uint32_t a = random_bits(&state, &reservoir, 5);
+        counts[a << 5 | random_bits(&state, &reservoir, 5)]++;
+    }
+    for (size_t b = 0; b < 1024; b++) {
+        probs[b] = 1.0;
+    }
+    test_chi2("random_bits 5, pairs", counts, probs, 1024);
+}
+
+static void test_bernoulli(void) {
+    static const double ps[] = {0.0, 0.01, 0.1, 0.3, 0.5, 0.999, 1.0};
+    for (size_t j = 0; j < sizeof(ps) / sizeof(ps[0]); j++) {
+        const double p = ps[j];
+        const uint64_t threshold = random_bernoulli_threshold(p);
+        char name[96];
+
+        RandomState state;
+        next_state(&state);
+        RandomState copy = state;
+        size_t hits = 0;
+        size_t differ = 0;
+        for (size_t i = 0; i < N; i++) {
+            const int b = random_bernoulli(&state, threshold);
+            hits += (size_t)b;
+            differ += b != (random_double_01(&copy) < p);
+        }
+        snprintf(name, sizeof(name), "random_bernoulli p %g", p);
+        if (p == 0.0 || p == 1.0) {
+            test_check(hits == (p == 0.0 ? 0 : N), name, hits == (p == 0.0 ? 0 : N) ? "exact" : "wrong outcomes");
+        } else {
+            test_count(name, hits, N, p);
+        }
+        snprintf(name, sizeof(name), "random_bernoulli p %g vs random_double_01", p);
+        test_check(differ == 0, name, differ ? "outcomes differ" : "same outcomes");
+
+        // Each bit of a mask is a trial, so the number of set bits is
+        // binomial with n = 64, which also catches correlated bits. Bit 0 and
+        // 63 are checked on their own, being the first and last lane.
+        const size_t masks = N / 64;
+        size_t popcounts[65] = {0};
+        size_t first = 0;
+        size_t last = 0;
+        for (size_t i = 0; i < masks; i++) {
+            const uint64_t mask = random_bernoulli_mask(&state, threshold);
+            popcounts[popcount(mask)]++;
+            first += mask & 1;
+            last += mask >> 63;
+        }
+        snprintf(name, sizeof(name), "random_bernoulli_mask p %g", p);
+        if (p == 0.0 || p == 1.0) {
+            const int ok = popcounts[p == 0.0 ? 0 : 64] == masks;
+            test_check(ok, name, ok ? "exact" : "wrong outcomes");
+            continue;
+        }
+        double pmf[65];
+        for (int k = 0; k <= 64; k++) {
+            pmf[k] = exp(lgamma(65.0) - lgamma(k + 1.0) - lgamma(65.0 - k) + k * log(p) + (64 - k) * log1p(-p));
+        }
+        test_chi2(name, popcounts, pmf, 65);
+        snprintf(name, sizeof(name), "random_bernoulli_mask p %g bit 0", p);
+        test_count(name, first, masks, p);
+        snprintf(name, sizeof(name), "random_bernoulli_mask p %g bit 63", p);
+        test_count(name, last, masks, p);
+    }
+}
+
+// Poisson and binomial
+
+// Counts the values below max and puts the rest in a last bin, whose
+// probability is what the first max bins leave
+static void check_discrete(const char *name, const uint64_t *x, double *pmf, size_t max, uint64_t limit) {
+    size_t *counts = (size_t *)calloc(max + 1, sizeof(size_t));
+    size_t outside = 0;
+    for (size_t i = 0; i < N; i++) {
+        if (x[i] > limit) {
+            outside++;
+        } else {
+            counts[x[i] < max ? x[i] : max]++;
+        }
+    }
+
+    double sum = 0.0;
+    for (size_t k = 0; k < max; k++) {
+        sum += pmf[k];
+    }
+    pmf[max] = sum < 1.0 ? 1.0 - sum : 0.0;
+
+    if (test_check(outside == 0, name, outside ? "values out of range" : "all values in range")) {
+        test_chi2(name, counts, pmf, max + 1);
+    }
+    free(counts);
+}
+
+static void test_poisson(uint64_t *x) {
+    // Both sides of the switch from inversion to PTRS at 10
+    static const double lambdas[] = {0.01, 0.5, 4.0, 9.99, 10.0, 30.0, 250.0, 1e5};
+    for (size_t i = 0; i < sizeof(lambdas) / sizeof(lambdas[0]); i++) {
+        const double lambda = lambdas[i];
+        const size_t max = (size_t)(lambda + 10.0 * sqrt(lambda) + 20.0);
+        double *pmf = (double *)malloc((max + 1) * sizeof(double));
+        for (size_t k = 0; k < max; k++) {
+            pmf[k] = exp((double)k * log(lambda) - lambda - lgamma((double)k + 1.0));
+        }
+
+        for (int fill = 0; fill < 2; fill++) {
+            RandomState state;
+            next_state(&state);
+            if (fill) {
+                random_fill_poisson(&state, x, N, lambda);
+            } else {
+                for (size_t j = 0; j < N; j++) {
+                    x[j] = random_poisson(&state, lambda);
+                }
+            }
+
+            char name[96];
+            snprintf(name, sizeof(name), "%s lambda %g", fill ? "random_fill_poisson" : "random_poisson", lambda);
+            check_discrete(name, x, pmf, max, UINT64_MAX);
+        }
+        free(pmf);
+    }
+}
+
+static void test_binomial(uint64_t *x) {
+    // Both sides of the switch from inversion to BTRS at n * min(p, 1 - p) = 10
+    static const struct {
+        uint64_t n;
+        double p;
+    } params[] = {
+        {1, 0.5}, {20, 0.3}, {100, 0.05}, {100, 0.0999}, {100, 0.1}, {100, 0.5}, {50, 0.99},
+        {1000, 0.7}, {100000, 0.01}, {1000000000, 0.5},
+    };
+    for (size_t i = 0; i < sizeof(params) / sizeof(params[0]); i++) {
+        const uint64_t n = params[i].n;
+        const double p = params[i].p;
+        const double mean = (double)n * p;
+        const double sd = sqrt(mean * (1.0 - p));
+        const double lo = floor(mean - 10.0 * sd - 20.0);
+        const size_t first = lo > 0.0 ? (size_t)lo : 0;
+        const double hi = mean + 10.0 * sd + 20.0;
+        const size_t max = (size_t)(hi < (double)n ? hi : (double)n) - first + 1;
+
+        // Bin k counts first + k, values below first go to the last bin too
+        double *pmf = (double *)malloc((max + 1) * sizeof(double));
+        for (size_t k = 0; k < max; k++) {
+            const double j = (double)(first + k);
+            pmf[k] = exp(lgamma((double)n + 1.0) - lgamma(j + 1.0) - lgamma((double)n - j + 1.0) + j * log(p) +
+                         ((double)n - j) * log1p(-p));
+        }
+
+        for (int fill = 0; fill < 2; fill++) {
+            RandomState state;
+            next_state(&state);
+            if (fill) {
+                random_fill_binomial(&state, x, N, n, p);
+            } else {
+                for (size_t j = 0; j < N; j++) {
+                    x[j] = random_binomial(&state, n, p);
+                }
+            }
+            for (size_t j = 0; j < N; j++) {
+                x[j] = x[j] > n ? UINT64_MAX : x[j] >= first ? x[j] - first : max;
+            }
+
+            char name[96];
+            snprintf(name, sizeof(name), "%s n %llu p %g", fill ? "random_fill_binomial" : "random_binomial",
+                     (unsigned long long)n, p);
+            check_discrete(name, x, pmf, max, n);
+        }
+        free(pmf);
+    }
+}
+
+// Continuous distributions
+
+static double uniform_cdf(double x) {
+    return x < 0.0 ? 0.0 : x > 1.0 ? 1.0 : x;
+}
+
+static void check_continuous(const char *name, double *x, int exponential) {
+    char full[96];
+    int in_range = 1;
+    for (size_t i = 0; i < N; i++) {
+        in_range &= exponential ? x[i] >= 0.0 && x[i] < INFINITY : x[i] >= 0.0 && x[i] < 1.0;
+    }
+    snprintf(full, sizeof(full), "%s range", name);
+    test_check(in_range, full, in_range ? "all values in range" : "values out of range");
+    snprintf(full, sizeof(full), "%s moments", name);
+    if (exponential) {
+        test_moments(full, x, N, 1.0, 1.0, 6.0, 0);
+    } else {
+        test_moments(full, x, N, 0.5, 1.0 / 12.0, -1.2, 0);
+    }
+    snprintf(full, sizeof(full), "%s KS", name);
+    test_ks(full, x, N, exponential ? test_exponential_cdf : uniform_cdf);
+}
+
+static void test_exponential(double *x) {
+    // Rate 2, scaled back to rate 1
+    const double lambda = 2.0;
+    RandomState state;
+    next_state(&state);
+    for (size_t i = 0; i < N; i++) {
+        x[i] = lambda * random_double_exponential(&state, lambda);
+    }
+    check_continuous("random_double_exponential", x, 1);
+
+    next_state(&state);
+    for (size_t i = 0; i < N; i += 1000) {
+        const size_t m = N - i < 1000 ? N - i : 1000;
+        random_fill_double_exponential(&state, x + i, m, lambda);
+    }
+    for (size_t i = 0; i < N; i++) {
+        x[i] *= lambda;
+    }
+    check_continuous("random_fill_double_exponential", x, 1);
+}
+
+#define UNIFORM_SINGLE(name, call) \
+    do { \
+        RandomState state; \
+        next_state(&state); \
+        for (size_t i = 0; i < N; i++) { \
+            x[i] = call(&state); \
+        } \
+        check_continuous(name, x, 0); \
+    } while (0)
+
+#define UNIFORM_FILL(name, type, State, seed_call, fill_call) \
+    do { \
+        State state; \
+        seed_call(&state, seed++); \
+        type buffer[999]; \
+        for (size_t i = 0; i < N; i += 999) { \
+            const size_t m = N - i < 999 ? N - i : 999; \
+            fill_call(&state, buffer, m); \
+            for (size_t j = 0; j < m; j++) { \
+                x[i + j] = buffer[j]; \
+            } \
+        } \
+        check_continuous(name, x, 0); \
+    } while (0)
+
+// random_buffer_float_01 and random_buffer_double_01 from a buffer seeded
+// with the next seed
+#define UNIFORM_BUFFER(name, call) \
+    do { \
+        static RandomBuffer buffer; \
+        random_buffer_init(&buffer, seed++); \
+        for (size_t i = 0; i < N; i++) { \
+            x[i] = call(&buffer); \
+        } \
+        check_continuous(name, x, 0); \
+    } while (0)
+
+// random_float, random_double and their fills on -1 <= x < 1, mapped back to
+// 0 <= x < 1
+#define UNIFORM_SCALED(name, type, call) \
+    do { \
+        RandomState state; \
+        next_state(&state); \
+        for (size_t i = 0; i < N; i++) { \
+            x[i] = ((double)call(&state, (type)-1, (type)1) + 1.0) / 2.0; \
+        } \
+        check_continuous(name, x, 0); \
+    } while (0)
+
+#define UNIFORM_SCALED_FILL(name, type, fill_call) \
+    do { \
+        RandomState state; \
+        next_state(&state); \
+        type buffer[999]; \
+        for (size_t i = 0; i < N; i += 999) { \
+            const size_t m = N - i < 999 ? N - i : 999; \
+            fill_call(&state, buffer, m, (type)-1, (type)1); \
+            for (size_t j = 0; j < m; j++) { \
+                x[i + j] = ((double)buffer[j] + 1.0) / 2.0; \
+            } \
+        } \
+        check_continuous(name, x, 0); \
+    } while (0)
+
+static void test_uniform(double *x) {
+    UNIFORM_SINGLE("random_float_01", random_float_01);
+    UNIFORM_SINGLE("random_double_01", random_double_01);
+    UNIFORM_SINGLE("random_float_01_fast", random_float_01_fast);
+    UNIFORM_SINGLE("random_double_01_fast", random_double_01_fast);
+    UNIFORM_SINGLE("random_float_01_full", random_float_01_full);
+    UNIFORM_SINGLE("random_double_01_full", random_double_01_full);
+    UNIFORM_SINGLE("rf_float_01", rf_float_01);
+    UNIFORM_SINGLE("rf_double_01", rf_double_01);
+    UNIFORM_SINGLE("rf_float_01_fast", rf_float_01_fast);
+    UNIFORM_SINGLE("rf_double_01_fast", rf_double_01_fast);
+    UNIFORM_SINGLE("rf_float_01_full", rf_float_01_full);
+    UNIFORM_SINGLE("rf_double_01_full", rf_double_01_full);
+
+    UNIFORM_BUFFER("random_buffer_float_01", random_buffer_float_01);
+    UNIFORM_BUFFER("random_buffer_double_01", random_buffer_double_01);
+    UNIFORM_SCALED("random_float", float, random_float);
+    UNIFORM_SCALED("random_double", double, random_double);
+    UNIFORM_SCALED_FILL("random_fill_float", float, random_fill_float);
+    UNIFORM_SCALED_FILL("random_fill_double", double, random_fill_double);
+
+    // Both halves of random_float2_01, interleaved like the float fills
+    RandomState state;
+    next_state(&state);
+    for (size_t i = 0; i < N; i += 2) {
+        float pair[2];
+        random_float2_01(&state, pair);
+        x[i] = pair[0];
+        x[i + 1] = pair[1];
+    }
+    check_continuous("random_float2_01", x, 0);
+
+    UNIFORM_FILL("random_fill_float_01", float, RandomState, random_seed, random_fill_float_01);
+    UNIFORM_FILL("random_fill_double_01", double, RandomState, random_seed, random_fill_double_01);
+    UNIFORM_FILL("rf_fill_float_01", float, RFState, rf_seed, rf_fill_float_01);
+    UNIFORM_FILL("rf_fill_double_01", double, RFState, rf_seed, rf_fill_double_01);
+    UNIFORM_FILL("rf_fill_float_01_x4", float, RFStateX4, rf_seed_x4, rf_fill_float_01_x4);
+    UNIFORM_FILL("rf_fill_float_01_x8", float, RFStateX8, rf_seed_x8, rf_fill_float_01_x8);
+    UNIFORM_FILL("rf_fill_double_01_x4", double, RFStateX4, rf_seed_x4, rf_fill_double_01_x4);
+    UNIFORM_FILL("rf_fill_double_01_x8", double, RFStateX8, rf_seed_x8, rf_fill_double_01_x8);
+    UNIFORM_FILL("rf_fill_float_01_x4_dispatch", float, RFStateX4, rf_seed_x4, rf_fill_float_01_x4_dispatch);
+    UNIFORM_FILL("rf_fill_float_01_x8_dispatch", float, RFStateX8, rf_seed_x8, rf_fill_float_01_x8_dispatch);
+    UNIFORM_FILL("rf_fill_double_01_x4_dispatch", double, RFStateX4, rf_seed_x4, rf_fill_double_01_x4_dispatch);
+    UNIFORM_FILL("rf_fill_double_01_x8_dispatch", double, RFStateX8, rf_seed_x8, rf_fill_double_01_x8_dispatch);
+}
+
+int main(void) {
+    uint64_t *x = (uint64_t *)malloc(N * sizeof(uint64_t));
+    if (!x) {
+        return EXIT_FAILURE;
+    }
+
+    test_ranges(x);
+    test_alias(x);
+    test_shuffle();
+    test_subsets();
+    test_bits();
+    test_bernoulli();
+    test_poisson(x);
+    test_binomial(x);
+    test_exponential((double *)(void *)x);
+    test_uniform((double *)(void *)x);
+
+    free(x);
+    return test_result();
+}
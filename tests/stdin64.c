@@ -0,0 +1,196 @@
+// Streams raw 64 bit outputs to stdout for external test suites, e.g.
+//
+//     ./stdin64 x8_dispatch | RNG_test stdin64 -tlmax 1TB
+//
+// for PractRand, or the TestU01 batteries through a reader of stdin. Each
+// engine is one generator or one bulk or multi-lane path, so a change that only
+// breaks e.g. the AVX-512 lanes shows up in that engine alone. The outputs are
+// produced by the fill functions into a 512 KiB block per write, so the stream
+// runs at close to the speed of the generator itself. The single value engines
+// keep a local copy of the state, like the fill functions do.
+//
+// Usage: stdin64 ENGINE [SEED [BYTES]]
+//
+// BYTES stops the stream after that many bytes (rounded up to whole blocks),
+// otherwise it runs until the reader closes the pipe. Run without arguments to
+// list the engines. The rf_ engines are xoshiro256+, whose lowest bits fail
+// linear complexity tests by design, so expect PractRand to flag those; the
+// float conversions only use the high bits.
+
+#define RANDOM_IMPLEMENTATION
+#include "random.h"
+#include "random_float.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK ((size_t)1 << 16)
+
+typedef struct {
+    RandomState state;
+    RandomStateX4 x4;
+    RandomStateX8 x8;
+    RandomBuffer buffer;
+    uint64_t key;
+    uint64_t counter;
+} Streams;
+
+static void fill_u64(Streams *s, uint64_t *out, size_t n) {
+    RandomState state = s->state;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random_u64(&state);
+    }
+    s->state = state;
+}
+
+static void fill_fill_u64(Streams *s, uint64_t *out, size_t n) {
+    random_fill_u64(&s->state, out, n);
+}
+
+static void fill_bytes(Streams *s, uint64_t *out, size_t n) {
+    random_fill_bytes(&s->state, out, 8 * n);
+}
+
+static void fill_buffer(Streams *s, uint64_t *out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = random_buffer_u64(&s->buffer);
+    }
+}
+
+static void fill_x4(Streams *s, uint64_t *out, size_t n) {
+    random_fill_u64_x4(&s->x4, out, n);
+}
+
+static void fill_x8(Streams *s, uint64_t *out, size_t n) {
+    random_fill_u64_x8(&s->x8, out, n);
+}
+
+static void fill_x4_dispatch(Streams *s, uint64_t *out, size_t n) {
+    random_fill_u64_x4_dispatch(&s->x4, out, n);
+}
+
+static void fill_x8_dispatch(Streams *s, uint64_t *out, size_t n) {
+    random_fill_u64_x8_dispatch(&s->x8, out, n);
+}
+
+static void fill_bytes_x4(Streams *s, uint64_t *out, size_t n) {
+    random_fill_bytes_x4(&s->x4, out, 8 * n);
+}
+
+static void fill_bytes_x8(Streams *s, uint64_t *out, size_t n) {
+    random_fill_bytes_x8(&s->x8, out, 8 * n);
+}
+
+static void fill_bytes_x4_dispatch(Streams *s, uint64_t *out, size_t n) {
+    random_fill_bytes_x4_dispatch(&s->x4, out, 8 * n);
+}
+
+static void fill_bytes_x8_dispatch(Streams *s, uint64_t *out, size_t n) {
+    random_fill_bytes_x8_dispatch(&s->x8, out, 8 * n);
+}
+
+static void fill_at(Streams *s, uint64_t *out, size_t n) {
+    random_fill_at(s->key, s->counter, out, n);
+    s->counter += n;
+}
+
+static void fill_rf(Streams *s, uint64_t *out, size_t n) {
+    RFState state = s->state;
+    for (size_t i = 0; i < n; i++) {
+        out[i] = rf__next(&state);
+    }
+    s->state = state;
+}
+
+static void fill_rf_x4(Streams *s, uint64_t *out, size_t n) {
+    RFStateX4 state = s->x4;
+    for (size_t i = 0; i < n; i += 4) {
+        rf__next_x4(&state, out + i);
+    }
+    s->x4 = state;
+}
+
+static void fill_rf_x8(Streams *s, uint64_t *out, size_t n) {
+    RFStateX8 state = s->x8;
+    for (size_t i = 0; i < n; i += 8) {
+        rf__next_x8(&state, out + i);
+    }
+    s->x8 = state;
+}
+
+static const struct {
+    const char *name;
+    void (*fill)(Streams *s, uint64_t *out, size_t n);
+    const char *help;
+} engines[] = {
+    {"u64", fill_u64, "random_u64"},
+    {"fill_u64", fill_fill_u64, "random_fill_u64"},
+    {"bytes", fill_bytes, "random_fill_bytes"},
+    {"buffer", fill_buffer, "random_buffer_u64"},
+    {"x4", fill_x4, "random_fill_u64_x4"},
+    {"x8", fill_x8, "random_fill_u64_x8"},
+    {"x4_dispatch", fill_x4_dispatch, "random_fill_u64_x4_dispatch"},
+    {"x8_dispatch", fill_x8_dispatch, "random_fill_u64_x8_dispatch"},
+    {"bytes_x4", fill_bytes_x4, "random_fill_bytes_x4"},
+    {"bytes_x8", fill_bytes_x8, "random_fill_bytes_x8"},
+    {"bytes_x4_dispatch", fill_bytes_x4_dispatch, "random_fill_bytes_x4_dispatch"},
+    {"bytes_x8_dispatch", fill_bytes_x8_dispatch, "random_fill_bytes_x8_dispatch"},
+    {"at", fill_at, "random_fill_at, Philox4x32-10 keyed with the seed"},
+    {"rf", fill_rf, "rf__next, xoshiro256+"},
+    {"rf_x4", fill_rf_x4, "rf__next_x4, xoshiro256+"},
+    {"rf_x8", fill_rf_x8, "rf__next_x8, xoshiro256+"},
+};
+
+#define ENGINE_COUNT (sizeof(engines) / sizeof(engines[0]))
+
+static int usage(void) {
+    fprintf(stderr, "usage: stdin64 ENGINE [SEED [BYTES]]\n\nengines:\n");
+    for (size_t i = 0; i < ENGINE_COUNT; i++) {
+        fprintf(stderr, "  %-18s %s\n", engines[i].name, engines[i].help);
+    }
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || argc > 4) {
+        return usage();
+    }
+
+    size_t e = 0;
+    while (e < ENGINE_COUNT && strcmp(argv[1], engines[e].name) != 0) {
+        e++;
+    }
+    if (e == ENGINE_COUNT) {
+        return usage();
+    }
+
+    const uint64_t seed = argc > 2 ? strtoull(argv[2], NULL, 0) : 0;
+    const unsigned long long limit = argc > 3 ? strtoull(argv[3], NULL, 0) : 0;
+
+    static Streams s;
+    random_seed(&s.state, seed);
+    random_seed_x4(&s.x4, seed);
+    random_seed_x8(&s.x8, seed);
+    random_buffer_init(&s.buffer, seed);
+    s.key = seed;
+
+    uint64_t *block = (uint64_t *)malloc(BLOCK * sizeof(uint64_t));
+    if (!block) {
+        return EXIT_FAILURE;
+    }
+
+    // The reader closing the pipe ends the stream, either through SIGPIPE or a
+    // short write
+    unsigned long long written = 0;
+    while (!limit || written < limit) {
+        engines[e].fill(&s, block, BLOCK);
+        if (fwrite(block, sizeof(uint64_t), BLOCK, stdout) != BLOCK) {
+            break;
+        }
+        written += BLOCK * sizeof(uint64_t);
+    }
+
+    free(block);
+    return EXIT_SUCCESS;
+}
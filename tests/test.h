@@ -0,0 +1,165 @@
+/* test.h, statistics helpers shared by the tests in this directory.
+
+Every check prints one line, "ok" or "FAIL" followed by the name of the check
+and its statistic, and test_result returns the exit code for main. The tests
+use fixed seeds, so a run is deterministic, and the limits are loose enough
+(p > 1e-6 or |z| < 5) that a correct sampler never fails them, while a
+distribution that is off by a fraction of a percent does.
+
+*/
+
+#ifndef TEST_H_INCLUDE
+#define TEST_H_INCLUDE
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TEST_MIN_P 1e-6
+#define TEST_MAX_Z 5.0
+
+static int test__failures;
+
+static inline int test_check(int ok, const char *name, const char *detail) {
+    printf("%-4s %s: %s\n", ok ? "ok" : "FAIL", name, detail);
+    if (!ok) {
+        test__failures++;
+    }
+    return ok;
+}
+
+static inline int test_result(void) {
+    if (test__failures) {
+        printf("%d checks failed\n", test__failures);
+    }
+    return test__failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+static inline double test_normal_cdf(double x) {
+    return 0.5 * erfc(-x / sqrt(2.0));
+}
+
+static inline double test_exponential_cdf(double x) {
+    return x > 0.0 ? -expm1(-x) : 0.0;
+}
+
+static inline int test__compare_double(const void *a, const void *b) {
+    const double x = *(const double *)a;
+    const double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Kolmogorov-Smirnov test of x against cdf, sorts x in place. The p-value uses
+// the asymptotic Kolmogorov distribution, which is accurate for large n.
+static inline int test_ks(const char *name, double *x, size_t n, double (*cdf)(double)) {
+    qsort(x, n, sizeof(double), test__compare_double);
+    double d = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        const double f = cdf(x[i]);
+        const double lo = f - (double)i / (double)n;
+        const double hi = (double)(i + 1) / (double)n - f;
+        d = lo > d ? lo : d;
+        d = hi > d ? hi : d;
+    }
+
+    const double t = (sqrt((double)n) + 0.12 + 0.11 / sqrt((double)n)) * d;
+    double p = 0.0;
+    for (int k = 1; k <= 100; k++) {
+        p += (k & 1 ? 2.0 : -2.0) * exp(-2.0 * k * k * t * t);
+    }
+    p = p < 0.0 ? 0.0 : p > 1.0 ? 1.0 : p;
+
+    char detail[64];
+    snprintf(detail, sizeof(detail), "KS D = %.6f, p = %.4g", d, p);
+    return test_check(p > TEST_MIN_P, name, detail);
+}
+
+// Compares the sample mean and variance with the expected ones, using the
+// standard errors implied by the expected excess kurtosis. The skewness and
+// kurtosis are only checked for a normal distribution, where their standard
+// errors are sqrt(6 / n) and sqrt(24 / n).
+static inline int test_moments(const char *name, const double *x, size_t n, double mean, double var, double kurtosis,
+                               int normal) {
+    double m1 = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        m1 += x[i];
+    }
+    m1 /= (double)n;
+
+    double m2 = 0.0;
+    double m3 = 0.0;
+    double m4 = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        const double d = x[i] - m1;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+    }
+    m2 /= (double)n;
+    m3 /= (double)n;
+    m4 /= (double)n;
+
+    const double z_mean = (m1 - mean) / sqrt(var / (double)n);
+    const double z_var = (m2 - var) / sqrt((kurtosis + 2.0) * var * var / (double)n);
+    const double z_skew = normal ? m3 / pow(m2, 1.5) / sqrt(6.0 / (double)n) : 0.0;
+    const double z_kurt = normal ? (m4 / (m2 * m2) - 3.0) / sqrt(24.0 / (double)n) : 0.0;
+
+    char detail[128];
+    snprintf(detail, sizeof(detail), "mean %.5f (z %.2f), variance %.5f (z %.2f)", m1, z_mean, m2, z_var);
+    if (normal) {
+        snprintf(detail + strlen(detail), sizeof(detail) - strlen(detail), ", z skew %.2f, z kurtosis %.2f",
+                 z_skew, z_kurt);
+    }
+    return test_check(fabs(z_mean) < TEST_MAX_Z && fabs(z_var) < TEST_MAX_Z && fabs(z_skew) < TEST_MAX_Z &&
+                      fabs(z_kurt) < TEST_MAX_Z, name, detail);
+}
+
+// Binomial z-score of count hits in n trials with probability p
+static inline int test_count(const char *name, size_t count, size_t n, double p) {
+    const double expected = p * (double)n;
+    const double z = ((double)count - expected) / sqrt(expected * (1.0 - p));
+    char detail[96];
+    snprintf(detail, sizeof(detail), "%zu hits, %.1f expected (z %.2f)", count, expected, z);
+    return test_check(fabs(z) < TEST_MAX_Z, name, detail);
+}
+
+// Chi-square test of k bins against the given probabilities, which are scaled
+// by their sum. Adjacent bins are merged until each one expects at least 5
+// hits. The statistic is mapped to a z-score with the Wilson-Hilferty
+// approximation, and both tails fail, so outputs that are too even do too.
+static inline int test_chi2(const char *name, const size_t *counts, const double *probs, size_t k) {
+    double n = 0.0;
+    double total = 0.0;
+    for (size_t i = 0; i < k; i++) {
+        n += (double)counts[i];
+        total += probs[i];
+    }
+
+    double chi2 = 0.0;
+    double observed = 0.0;
+    double expected = 0.0;
+    size_t bins = 0;
+    for (size_t i = 0; i < k; i++) {
+        observed += (double)counts[i];
+        expected += probs[i] / total * n;
+        if (expected >= 5.0 || i == k - 1) {
+            if (expected > 0.0) {
+                chi2 += (observed - expected) * (observed - expected) / expected;
+                bins++;
+            } else if (observed > 0.0) {
+                chi2 = INFINITY;
+            }
+            observed = 0.0;
+            expected = 0.0;
+        }
+    }
+
+    const double df = bins > 1 ? (double)(bins - 1) : 1.0;
+    const double z = (cbrt(chi2 / df) - (1.0 - 2.0 / (9.0 * df))) / sqrt(2.0 / (9.0 * df));
+    char detail[96];
+    snprintf(detail, sizeof(detail), "chi2 = %.1f, %zu bins (z %.2f)", chi2, bins, z);
+    return test_check(fabs(z) < TEST_MAX_Z, name, detail);
+}
+
+#endif  //  TEST_H_INCLUDE